@@ -122,7 +122,6 @@ import purpletreesoftware.karuahchess.viewmodel.AboutViewModel
 import purpletreesoftware.karuahchess.viewmodel.CastlingRightsViewModel
 import purpletreesoftware.karuahchess.viewmodel.PawnPromotionViewModel
 import java.io.InputStream
-import java.util.SortedMap
 
 
 @ExperimentalUnsignedTypes
@@ -831,10 +830,18 @@ open class MainActivity(pActivityID: Int) : AppCompatActivity(), TilePanel.OnTil
             }
 
             searchOptions.randomiseFirstMove = ParameterDataService.getInstance(activityID).get(ParamRandomiseFirstMove::class.java).enabled
-            searchOptions.alternateMove = isRepeatMove();
 
             val topMove = withContext(Dispatchers.IO) { GameRecordDataService.getInstance(activityID).currentGame.searchStart(searchOptions) }
-            doMoveOnBoard(topMove)
+            val moved = doMoveOnBoard(topMove)
+
+            // Think about the expected reply while waiting for the user, or about the
+            // likely replies when there is no expected one
+            if (moved && GameRecordDataService.getInstance(activityID).currentGame.getStateGameStatus() == BoardStatusEnum.Ready.value) {
+                withContext(Dispatchers.IO) {
+                    val currentGame = GameRecordDataService.getInstance(activityID).currentGame
+                    if (!currentGame.ponderStart(searchOptions)) currentGame.speculateStart(searchOptions)
+                }
+            }
 
             // Unlock panel, stop the progress indicator
             binding.moveProgressBar.visibility = View.GONE
@@ -851,8 +858,7 @@ open class MainActivity(pActivityID: Int) : AppCompatActivity(), TilePanel.OnTil
      */
     private suspend fun startHintTask(pRecord: GameRecordArray)
     {
-        hintBoard.setBoardArray(pRecord.boardArray)
-        hintBoard.setStateArray(pRecord.stateArray)
+        GameRecordDataService.getInstance(activityID).setBoardFromHistory(hintBoard, pRecord.id)
 
         val arrangeBoardEnabled =  ParameterDataService.getInstance(activityID).get(ParamArrangeBoard::class.java).enabled
         val boardStatus = hintBoard.getStateGameStatus()
@@ -870,7 +876,6 @@ open class MainActivity(pActivityID: Int) : AppCompatActivity(), TilePanel.OnTil
             searchOptions.limitMoveDuration = Constants.strengthList[Constants.strengthList.lastIndex].pTimeLimitms
             searchOptions.limitThreads = if (Runtime.getRuntime().availableProcessors() > 1) Runtime.getRuntime().availableProcessors() - 1 else 1
             searchOptions.randomiseFirstMove = false
-            searchOptions.alternateMove = false
 
             val topMove = withContext(Dispatchers.IO) { hintBoard.searchStart(searchOptions) }
 
@@ -2254,45 +2259,6 @@ open class MainActivity(pActivityID: Int) : AppCompatActivity(), TilePanel.OnTil
         return activityID
     }
 
-    /**
-     * Detect a repeat move
-     */
-    private fun isRepeatMove(): Boolean {
-        var repeated: Boolean = false
-        val history: SortedMap<Int, GameRecordArray> = GameRecordDataService.getInstance(activityID).gameHistory()
-
-        val endIndex: Int = history.size - 1
-        if (endIndex >= 4) {
-            val currentBoardArray: ULongArray = history.values.elementAt(endIndex).boardArray
-
-            var historyIndex = endIndex - 2
-            while (historyIndex >= 0) {
-                val historyBoardArray: ULongArray = history.values.elementAt(historyIndex).boardArray
-                var differenceFound: Boolean = false
-
-                if (currentBoardArray.size === historyBoardArray.size && historyBoardArray.size > 0) {
-                    // Compare all elements in both arrays and if one of them different,
-                    // then they are different boards
-                    for (i in 0 until currentBoardArray.size) {
-                        if (currentBoardArray[i] != historyBoardArray[i]) {
-                            differenceFound = true
-                            break
-                        }
-                    }
-
-                    // Break if difference not found as no need to search further
-                    if (!differenceFound) {
-                        repeated = true
-                        break
-                    }
-                }
-                historyIndex -= 2
-            }
-        }
-
-        return repeated
-    }
-
     /**
      * Routines to run on pause
      */
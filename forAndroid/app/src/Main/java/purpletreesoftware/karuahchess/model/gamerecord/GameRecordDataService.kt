@@ -87,11 +87,7 @@ class GameRecordDataService(pActivityID: Int): IGameRecordDataService{
         }
 
         // Set current game to latest bitboard
-        val latestRecord = get()
-        if(latestRecord != null) {
-            currentGame.setBoardArray(latestRecord.boardArray)
-            currentGame.setStateArray(latestRecord.stateArray)
-        }
+        setBoardFromHistory(currentGame, getMaxId())
 
     }
 
@@ -201,8 +197,7 @@ class GameRecordDataService(pActivityID: Int): IGameRecordDataService{
             val maxId = getMaxId()
             if (pGameRecordArray.id == maxId)
             {
-                currentGame.setBoardArray(pGameRecordArray.boardArray);
-                currentGame.setStateArray(pGameRecordArray.stateArray);
+                setBoardFromHistory(currentGame, maxId)
             }
         }
 
@@ -265,8 +260,7 @@ class GameRecordDataService(pActivityID: Int): IGameRecordDataService{
             clearFrom(lastMoveId)
 
             // Set the current game to a previous board
-            currentGame.setBoardArray(previousBoard.boardArray);
-            currentGame.setStateArray(previousBoard.stateArray);
+            setBoardFromHistory(currentGame, lastMoveId - 1)
 
             // Return true
             returnValue = true
@@ -358,6 +352,34 @@ class GameRecordDataService(pActivityID: Int): IGameRecordDataService{
         return history;
     }
 
+    /**
+     * Sets [pBoard] to the record [pId]. The moves since the last capture or pawn move are
+     * replayed from the earlier records, so the engine can detect repetitions.
+     */
+    override fun setBoardFromHistory(pBoard: KaruahChessEngine, pId: Int)
+    {
+        val record = gameRecordDict[pId] ?: return
+
+        // Find the first record which can be repeated
+        val halfMoveCount = record.stateArray[3]
+        var firstId = pId
+        while (firstId > pId - halfMoveCount && gameRecordDict.containsKey(firstId - 1)) firstId--
+
+        val firstRecord = gameRecordDict[firstId] ?: return
+        pBoard.setBoardArray(firstRecord.boardArray)
+        pBoard.setStateArray(firstRecord.stateArray)
+
+        for (id in firstId + 1..pId) {
+            val nextRecord = gameRecordDict[id] ?: continue
+
+            // An arranged board cannot be replayed, so the history starts again from it
+            if (!pBoard.replayMove(nextRecord.boardArray, nextRecord.stateArray)) {
+                pBoard.setBoardArray(nextRecord.boardArray)
+            }
+            pBoard.setStateArray(nextRecord.stateArray)
+        }
+    }
+
     /**
      * Determines the active move color for a specific record
     */
@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 package purpletreesoftware.karuahchess.model.gamerecord
 
 import purpletreesoftware.karuahchess.database.TableName
+import purpletreesoftware.karuahchess.engine.KaruahChessEngine
 import java.util.SortedMap
 
 
@@ -51,6 +52,8 @@ interface IGameRecordDataService {
 
     fun gameHistory(): SortedMap<Int, GameRecordArray>
 
+    fun setBoardFromHistory(pBoard: KaruahChessEngine, pId: Int)
+
     fun getActiveMoveColour(pId: Int): Int
 
     fun getStateGameStatus(pId: Int): Int
@@ -58,7 +58,7 @@ class Move {
             // Highlight squares
             if (pHighlight == HighlightEnum.MovePath)
             {
-                var sqMark = pBoard.getPotentialMove(pBoardSquareIndex)
+                var sqMark = pBoard.getLegalMove(pBoardSquareIndex)
                 if (sqMark and (Constants.BITMASK shr fromIndex) <= 0uL) sqMark = sqMark or (Constants.BITMASK shr fromIndex)
 
                 tilepanel.setHighLight(sqMark)
@@ -27,9 +27,6 @@
 -keepclasseswithmembers class purpletreesoftware.karuahchess.engine.KaruahChessEngineC {
     native <methods>;
  }
- -keepclasseswithmembers class purpletreesoftware.karuahchess.engine.KaruahChessEngineC1 {
-     native <methods>;
-  }
 -keepclasseswithmembers class purpletreesoftware.karuahchess.engine.MoveResult { *; }
 -keepclasseswithmembers class purpletreesoftware.karuahchess.engine.SearchResult { *; }
 -keepclasseswithmembers class purpletreesoftware.karuahchess.engine.SearchOptions { *; }
\ No newline at end of file
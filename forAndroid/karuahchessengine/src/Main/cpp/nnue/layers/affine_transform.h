@@ -37,7 +37,7 @@
     - accumulation happens directly to int32s
 */
 
-namespace Stockfish::Eval::NNUE::Layers {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA::Layers {
 
 #if defined(USE_SSSE3) || defined(USE_NEON_DOTPROD)
     #define ENABLE_SEQ_OPT
@@ -106,6 +106,36 @@ static void affine_transform_non_ssse3(std::int32_t*       output,
 
         #endif
     }
+    #elif defined(USE_GENERIC_SIMD)
+    // The products of the 8 bit weights and inputs fit in 16 bits
+    constexpr IndexType NumChunks   = ceil_to_multiple<IndexType>(InputDimensions, 16) / 8;
+    const auto          inputVector = reinterpret_cast<const Simd::vec_u8x8*>(input);
+
+    // Most inputs of the first layer are zero, so only the chunks with a non
+    // zero input are multiplied, as the scalar code does for single inputs
+    IndexType nnz[NumChunks];
+    IndexType count = 0;
+    for (IndexType j = 0; j < NumChunks; ++j)
+    {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, &inputVector[j], sizeof(chunk));
+        if (chunk)
+            nnz[count++] = j;
+    }
+
+    for (IndexType i = 0; i < OutputDimensions; ++i)
+    {
+        const auto      row = reinterpret_cast<const Simd::vec_i8x8*>(&weights[i * PaddedInputDimensions]);
+        Simd::vec_i32x8 sum = {};
+        for (IndexType k = 0; k < count; ++k)
+        {
+            const IndexType j = nnz[k];
+            const Simd::vec_i16x8 product = __builtin_convertvector(row[j], Simd::vec_i16x8)
+                                          * __builtin_convertvector(inputVector[j], Simd::vec_i16x8);
+            sum += __builtin_convertvector(product, Simd::vec_i32x8);
+        }
+        output[i] = Simd::generic_hadd(sum, biases[i]);
+    }
     #else
     std::memcpy(output, biases, sizeof(std::int32_t) * OutputDimensions);
 
@@ -26,8 +26,9 @@
 #include <iosfwd>
 
 #include "../nnue_common.h"
+#include "simd.h"
 
-namespace Stockfish::Eval::NNUE::Layers {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA::Layers {
 
 // Clipped ReLU
 template<IndexType InDims>
@@ -148,6 +149,15 @@ class ClippedReLU {
             out[i]          = vmax_s8(vqmovn_s16(shifted), Zero);
         }
         constexpr IndexType Start = NumChunks * (SimdWidth / 2);
+
+#elif defined(USE_GENERIC_SIMD)
+        constexpr IndexType NumChunks = InputDimensions / 4;
+        const auto          in        = reinterpret_cast<const Simd::vec_i32x4*>(input);
+        const auto          out       = reinterpret_cast<Simd::vec_u8x4*>(output);
+        for (IndexType i = 0; i < NumChunks; ++i)
+            out[i] = __builtin_convertvector(Simd::generic_clamp(in[i] >> WeightScaleBits, 0, 127),
+                                             Simd::vec_u8x4);
+        constexpr IndexType Start = NumChunks * 4;
 #else
         constexpr IndexType Start = 0;
 #endif
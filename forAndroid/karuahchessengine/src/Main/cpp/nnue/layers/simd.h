@@ -35,6 +35,12 @@
     #include <arm_neon.h>
 #endif
 
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../nnue_common.h"
+
 namespace Stockfish::Simd {
 
 #if defined(USE_AVX512)
@@ -128,6 +134,61 @@ dotprod_m128_add_dpbusd_epi32(int32x4_t& acc, int8x16_t a, int8x16_t b) {
     int16x8_t sum      = vpaddq_s16(product0, product1);
     acc                = vpadalq_s16(acc, sum);
 }
+#endif
+
+#if defined(USE_GENERIC_SIMD)
+
+// Karuah Chess - vector extension types for builds without a USE_* instruction
+// set. may_alias allows them to be loaded from the network and accumulator arrays.
+typedef std::int8_t  vec_i8x8 __attribute__((vector_size(8), may_alias));
+typedef std::uint8_t vec_u8x4 __attribute__((vector_size(4), may_alias));
+typedef std::uint8_t vec_u8x8 __attribute__((vector_size(8), may_alias));
+typedef std::int16_t vec_i16x8 __attribute__((vector_size(16), may_alias));
+typedef std::int32_t vec_i32x4 __attribute__((vector_size(16), may_alias));
+typedef std::int32_t vec_i32x8 __attribute__((vector_size(32)));
+
+template<typename V>
+[[maybe_unused]] static V generic_max(V a, V b) {
+    const V mask = a > b;
+    return (a & mask) | (b & ~mask);
+}
+
+template<typename V>
+[[maybe_unused]] static V generic_min(V a, V b) {
+    const V mask = a < b;
+    return (a & mask) | (b & ~mask);
+}
+
+template<typename V>
+[[maybe_unused]] static V generic_clamp(V v, int lo, int hi) {
+    using T = std::remove_cv_t<std::remove_reference_t<decltype(v[0])>>;
+    return generic_min(generic_max(v, V{} + T(lo)), V{} + T(hi));
+}
+
+// High 16 bits of the 32 bit products, as _mm_mulhi_epi16
+[[maybe_unused]] static vec_i16x8 generic_mulhi_16(vec_i16x8 a, vec_i16x8 b) {
+    const vec_i32x8 product =
+      __builtin_convertvector(a, vec_i32x8) * __builtin_convertvector(b, vec_i32x8);
+    return __builtin_convertvector(product >> 16, vec_i16x8);
+}
+
+// Saturates to unsigned bytes, a in the low half and b in the high half, as _mm_packus_epi16
+[[maybe_unused]] static vec_i16x8 generic_packus_16(vec_i16x8 a, vec_i16x8 b) {
+    const vec_u8x8 lo = __builtin_convertvector(generic_clamp(a, 0, 255), vec_u8x8);
+    const vec_u8x8 hi = __builtin_convertvector(generic_clamp(b, 0, 255), vec_u8x8);
+
+    vec_i16x8 packed;
+    std::memcpy(&packed, &lo, sizeof(lo));
+    std::memcpy(reinterpret_cast<char*>(&packed) + sizeof(lo), &hi, sizeof(hi));
+    return packed;
+}
+
+[[maybe_unused]] static int generic_hadd(const vec_i32x8& sum, int bias) {
+    for (int i = 0; i < 8; ++i)
+        bias += sum[i];
+    return bias;
+}
+
 #endif
 }
 
@@ -26,8 +26,9 @@
 #include <iosfwd>
 
 #include "../nnue_common.h"
+#include "simd.h"
 
-namespace Stockfish::Eval::NNUE::Layers {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA::Layers {
 
 // Clipped ReLU
 template<IndexType InDims>
@@ -84,6 +85,20 @@ class SqrClippedReLU {
         }
         constexpr IndexType Start = NumChunks * 16;
 
+#elif defined(USE_GENERIC_SIMD)
+        constexpr IndexType NumChunks = InputDimensions / 4;
+        const auto          in        = reinterpret_cast<const Simd::vec_i32x4*>(input);
+        const auto          out       = reinterpret_cast<Simd::vec_u8x4*>(output);
+        for (IndexType i = 0; i < NumChunks; ++i)
+        {
+            // Saturate to 16 bits first as the SSE2 code does, so the square fits in 32 bits
+            const Simd::vec_i32x4 words = Simd::generic_clamp(in[i], -32768, 32767);
+            out[i] = __builtin_convertvector(
+              Simd::generic_min((words * words) >> (2 * WeightScaleBits + 7), Simd::vec_i32x4{} + 127),
+              Simd::vec_u8x4);
+        }
+        constexpr IndexType Start = NumChunks * 4;
+
 #else
         constexpr IndexType Start = 0;
 #endif
@@ -75,9 +75,14 @@ struct AccumulatorCaches {
 
         template<typename Network>
         void clear(const Network& network) {
+            // Karuah Chess - the big network may still be loading in the background,
+            // the caches are cleared again when it is swapped in
+            if (!network.is_loaded())
+                return;
+
             for (auto& entries1D : entries)
                 for (auto& entry : entries1D)
-                    entry.clear(network.featureTransformer->biases);
+                    entry.clear(network.transformer()->biases);
         }
 
         void clear(const BiasType* biases) {
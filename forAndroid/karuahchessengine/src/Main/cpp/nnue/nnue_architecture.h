@@ -32,7 +32,7 @@
 #include "layers/sqr_clipped_relu.h"
 #include "nnue_common.h"
 
-namespace Stockfish::Eval::NNUE {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA {
 
 // Input features used in evaluation function
 using FeatureSet = Features::HalfKAv2_hm;
@@ -91,7 +91,7 @@ struct NetworkArchitecture {
             && fc_2.write_parameters(stream);
     }
 
-    std::int32_t propagate(const TransformedFeatureType* transformedFeatures) {
+    std::int32_t propagate(const TransformedFeatureType* transformedFeatures) const {
         struct alignas(CacheLineSize) Buffer {
             alignas(CacheLineSize) typename decltype(fc_0)::OutputBuffer fc_0_out;
             alignas(CacheLineSize) typename decltype(ac_sqr_0)::OutputType
@@ -46,7 +46,22 @@
     #include <arm_neon.h>
 #endif
 
-namespace Stockfish::Eval::NNUE {
+// Karuah Chess - builds without one of the instruction sets above use the
+// vector extensions of GCC and Clang, which the compiler maps to the vector
+// instructions of the target. Define NNUE_NO_GENERIC_SIMD for the scalar code.
+#if !defined(USE_SSE2) && !defined(USE_NEON) && (defined(__GNUC__) || defined(__clang__)) \
+  && !defined(NNUE_NO_GENERIC_SIMD)
+    #define USE_GENERIC_SIMD
+#endif
+
+// Karuah Chess - the inference code is compiled once for each instruction set
+// (see nnue_dispatch.h). Each compilation places the classes that depend on the
+// instruction set in its own inline namespace so they do not collide.
+#ifndef NNUE_ISA
+    #define NNUE_ISA isa_default
+#endif
+
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA {
 
 // Version of the evaluation file
 constexpr std::uint32_t Version = 0x7AF32F20u;
@@ -70,6 +85,9 @@ constexpr std::size_t SimdWidth = 16;
 
 #elif defined(USE_NEON)
 constexpr std::size_t SimdWidth = 16;
+
+#elif defined(USE_GENERIC_SIMD)
+constexpr std::size_t SimdWidth = 16;
 #endif
 
 constexpr std::size_t MaxSimdWidth = 32;
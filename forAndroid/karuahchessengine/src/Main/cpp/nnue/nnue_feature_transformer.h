@@ -33,8 +33,9 @@
 #include "nnue_accumulator.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
+#include "layers/simd.h"
 
-namespace Stockfish::Eval::NNUE {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA {
 
 using BiasType       = std::int16_t;
 using WeightType     = std::int16_t;
@@ -140,6 +141,30 @@ using psqt_vec_t = int32x4_t;
     #define NumRegistersSIMD 16
     #define MaxChunkSize 16
 
+#elif defined(USE_GENERIC_SIMD)
+using vec_t      = Simd::vec_i16x8;
+using psqt_vec_t = Simd::vec_i32x4;
+    #define vec_load(a) (*(a))
+    #define vec_store(a, b) *(a) = (b)
+    #define vec_add_16(a, b) ((a) + (b))
+    #define vec_sub_16(a, b) ((a) - (b))
+    #define vec_mulhi_16(a, b) Simd::generic_mulhi_16(a, b)
+    #define vec_zero() \
+        vec_t {}
+    #define vec_set_16(a) (vec_t{} + std::int16_t(a))
+    #define vec_max_16(a, b) Simd::generic_max(a, b)
+    #define vec_min_16(a, b) Simd::generic_min(a, b)
+    #define vec_slli_16(a, b) ((a) << (b))
+    #define vec_packus_16(a, b) Simd::generic_packus_16(a, b)
+    #define vec_load_psqt(a) (*(a))
+    #define vec_store_psqt(a, b) *(a) = (b)
+    #define vec_add_psqt_32(a, b) ((a) + (b))
+    #define vec_sub_psqt_32(a, b) ((a) - (b))
+    #define vec_zero_psqt() \
+        psqt_vec_t {}
+    #define NumRegistersSIMD 16
+    #define MaxChunkSize 16
+
 #else
     #undef VECTOR
 
@@ -406,7 +431,7 @@ class FeatureTransformer {
             // the multiplication.
 
             constexpr int shift =
-    #if defined(USE_SSE2)
+    #if defined(USE_SSE2) || defined(USE_GENERIC_SIMD)
               7;
     #else
               6;
@@ -37,6 +37,8 @@ Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
 Magic RookMagics[SQUARE_NB];
 Magic BishopMagics[SQUARE_NB];
 
+bool Bitboards::UsePext = false;
+
 namespace {
 
 Bitboard RookTable[0x19000];   // To store rook attacks
@@ -50,6 +52,16 @@ Bitboard safe_destination(Square s, int step) {
     Square to = Square(s + step);
     return is_ok(to) && distance(s, to) <= 2 ? square_bb(to) : Bitboard(0);
 }
+
+#if defined(USE_RUNTIME_PEXT)
+// AMD processors before Zen 3 have pext, but it is slower than the magic
+// multiplication there.
+bool has_fast_pext() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("amdfam15h")
+        && !__builtin_cpu_is("amdfam17h");
+}
+#endif
 }
 
 
@@ -64,6 +76,11 @@ void Bitboards::init() {
         for (Square s2 = SQ_A1; s2 <= SQ_H8; ++s2)
             SquareDistance[s1][s2] = std::max(distance<File>(s1, s2), distance<Rank>(s1, s2));
 
+#if defined(USE_RUNTIME_PEXT)
+    // The layout of the attack tables depends on the index, so this is set first
+    UsePext = has_fast_pext();
+#endif
+
     init_magics(ROOK, RookTable, RookMagics);
     init_magics(BISHOP, BishopTable, BishopMagics);
 
@@ -159,14 +176,14 @@ void init_magics(PieceType pt, Bitboard table[], Magic magics[]) {
             occupancy[size] = b;
             reference[size] = sliding_attack(pt, s, b);
 
-            if (HasPext)
-                m.attacks[pext(b, m.mask)] = reference[size];
+            if (HasPext || Bitboards::UsePext)
+                m.attacks[m.index(b)] = reference[size];
 
             size++;
             b = (b - m.mask) & m.mask;
         } while (b);
 
-        if (HasPext)
+        if (HasPext || Bitboards::UsePext)
             continue;
 
         PRNG rng(seeds[Is64Bit][rank_of(s)]);
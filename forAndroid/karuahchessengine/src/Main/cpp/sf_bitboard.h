@@ -34,6 +34,9 @@ namespace Bitboards {
 
 void        init();
 
+// Karuah Chess - set by init() when the build does not use pext but the
+// processor has a fast pext instruction, see USE_RUNTIME_PEXT
+extern bool UsePext;
 
 }  // namespace Stockfish::Bitboards
 
@@ -77,6 +80,16 @@ struct Magic {
         if (HasPext)
             return unsigned(pext(occupied, mask));
 
+#if defined(USE_RUNTIME_PEXT)
+        // The instruction is emitted directly as the build does not target BMI2
+        if (Bitboards::UsePext)
+        {
+            Bitboard index;
+            asm("pextq %2, %1, %0" : "=r"(index) : "r"(occupied), "rm"(mask));
+            return unsigned(index);
+        }
+#endif
+
         if (Is64Bit)
             return unsigned(((occupied & mask) * magic) >> shift);
 
@@ -263,7 +276,8 @@ inline Bitboard attacks_bb(PieceType pt, Square s, Bitboard occupied) {
 // Counts the number of non-zero bits in a bitboard.
 inline int popcount(Bitboard b) {
 
-#ifndef USE_POPCNT
+// Karuah Chess - the builtin compiles to popcnt in the BITBOARD_CLONES versions
+#if !defined(USE_POPCNT) && !defined(USE_BITBOARD_CLONES)
 
     union {
         Bitboard bb;
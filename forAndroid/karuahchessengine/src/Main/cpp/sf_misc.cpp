@@ -91,6 +91,22 @@ std::string engine_info(bool to_uci) {
 }
 
 
+// Used to serialize access to std::cout
+// to avoid multiple threads writing at the same time.
+std::ostream& operator<<(std::ostream& os, SyncCout sc) {
+
+    static std::mutex m;
+
+    if (sc == IO_LOCK)
+        m.lock();
+
+    if (sc == IO_UNLOCK)
+        m.unlock();
+
+    return os;
+}
+
+
 #ifdef NO_PREFETCH
 
 void prefetch(const void*) {}
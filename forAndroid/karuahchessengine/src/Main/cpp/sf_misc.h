@@ -20,6 +20,7 @@
 #define MISC_H_INCLUDED
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -28,6 +29,7 @@
 #include <iosfwd>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #define stringify2(x) #x
@@ -78,6 +80,10 @@ enum SyncCout {
     IO_LOCK,
     IO_UNLOCK
 };
+std::ostream& operator<<(std::ostream&, SyncCout);
+
+#define sync_cout std::cout << IO_LOCK
+#define sync_endl std::endl << IO_UNLOCK
 
 // True if and only if the binary is compiled on a little-endian machine
 static inline const union {
@@ -103,6 +109,81 @@ class ValueList {
 };
 
 
+// Karuah Chess - a lock-free ring buffer with one producer and one consumer.
+// The producer never waits: when the consumer is behind, push() drops the item
+// and counts it. The consumer can poll with pop(), or sleep in wait_pop() until
+// there is an item or the buffer is closed.
+template<typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "Items are copied as raw records");
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+   public:
+    // Producer
+    bool push(const T& item) {
+        const std::size_t w = writeIndex.load(std::memory_order_relaxed);
+        if (w - readIndex.load(std::memory_order_acquire) == Capacity)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        items[w & (Capacity - 1)] = item;
+        publish(w + 1);
+        return true;
+    }
+
+    // Producer, no more items will be pushed
+    void close() {
+        closed.store(true, std::memory_order_release);
+        publish(writeIndex.load(std::memory_order_relaxed));
+    }
+
+    // Consumer
+    bool pop(T& item) {
+        const std::size_t r = readIndex.load(std::memory_order_relaxed);
+        if (r == writeIndex.load(std::memory_order_acquire))
+            return false;
+
+        item = items[r & (Capacity - 1)];
+        readIndex.store(r + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, returns false when the buffer is closed and empty
+    bool wait_pop(T& item) {
+        while (!pop(item))
+        {
+            const std::uint32_t seen = signal.load(std::memory_order_acquire);
+            if (pop(item))
+                return true;
+            if (closed.load(std::memory_order_acquire))
+                return pop(item);
+            signal.wait(seen, std::memory_order_acquire);
+        }
+        return true;
+    }
+
+    std::size_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+   private:
+    // Waking a sleeping consumer is left to the library, which does not make a
+    // system call when there is no consumer waiting.
+    void publish(std::size_t w) {
+        writeIndex.store(w, std::memory_order_release);
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+
+    alignas(64) std::atomic<std::size_t> writeIndex{0};
+    std::atomic<std::uint32_t>           signal{0};
+    std::atomic<std::size_t>             droppedCount{0};
+    std::atomic<bool>                    closed{false};
+    alignas(64) std::atomic<std::size_t> readIndex{0};
+    alignas(64) T items[Capacity];
+};
+
+
 // xorshift64star Pseudo-Random Number Generator
 // This class is based on original code written and dedicated
 // to the public domain by Sebastiano Vigna (2014).
@@ -0,0 +1,153 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sf_perft.h"
+
+#include <deque>
+
+#include "sf_movegen.h"
+#include "sf_position.h"
+#include "sf_thread.h"
+
+namespace Stockfish::Benchmark {
+
+namespace {
+
+// Counts the leaf nodes below the position, counting the moves of the last ply
+// without making them. The depth is at least 2.
+uint64_t perft(Position& pos, Depth depth, PerftHash* hash) {
+
+    StateInfo st;
+    uint64_t  nodes = 0;
+
+    if (hash && hash->probe(pos.key(), depth, nodes))
+        return nodes;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        pos.do_move(m, st);
+        nodes += depth == 2 ? MoveList<LEGAL>(pos).size() : perft(pos, depth - 1, hash);
+        pos.undo_move(m);
+    }
+
+    if (hash)
+        hash->store(pos.key(), depth, nodes);
+
+    return nodes;
+}
+
+}  // namespace
+
+
+PerftHash::PerftHash(size_t mbSize) {
+
+    // Round down to a power of two so the index is a mask of the key
+    size_t entries = mbSize * 1024 * 1024 / sizeof(Entry);
+    count          = 1;
+    while (count * 2 <= entries)
+        count *= 2;
+
+    table = std::make_unique<Entry[]>(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        table[i].check.store(0, std::memory_order_relaxed);
+        table[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t PerftHash::index(Key key, Depth depth) const {
+    return (key ^ (Key(depth) * 0x9E3779B97F4A7C15ULL)) & (count - 1);
+}
+
+bool PerftHash::probe(Key key, Depth depth, uint64_t& nodes) const {
+
+    const Entry& e    = table[index(key, depth)];
+    uint64_t     data = e.data.load(std::memory_order_relaxed);
+    uint64_t     chk  = e.check.load(std::memory_order_relaxed);
+
+    if ((chk ^ data) != key || Depth(data & 0xFF) != depth)
+        return false;
+
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHash::store(Key key, Depth depth, uint64_t nodes) {
+
+    Entry&   e    = table[index(key, depth)];
+    uint64_t data = (nodes << 8) | uint64_t(depth & 0xFF);
+
+    e.data.store(data, std::memory_order_relaxed);
+    e.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+
+uint64_t perft(ThreadPool&                   threads,
+               const std::string&            fen,
+               Depth                         depth,
+               bool                          isChess960,
+               PerftHash*                    hash,
+               std::vector<PerftDivideItem>& divide) {
+
+    divide.clear();
+
+    // Karuah Chess - the root is the only node at depth 0
+    if (depth <= 0)
+        return 1;
+
+    StateListPtr states(new std::deque<StateInfo>(1));
+    Position     root;
+    root.set(fen, isChess960, &states->back());
+
+    for (const auto& m : MoveList<LEGAL>(root))
+        divide.push_back({m, depth <= 1 ? 1u : 0u});
+
+    if (depth > 1)
+    {
+        // Each thread takes the next root move until none are left
+        std::atomic<size_t> next(0);
+
+        for (size_t i = 0; i < threads.num_threads(); ++i)
+            threads.run_on_thread(i, [&]() {
+                StateListPtr threadStates(new std::deque<StateInfo>(1));
+                Position     pos;
+                pos.set(fen, isChess960, &threadStates->back());
+
+                StateInfo st;
+                for (size_t k = next++; k < divide.size(); k = next++)
+                {
+                    pos.do_move(divide[k].move, st);
+                    divide[k].nodes = depth == 2 ? MoveList<LEGAL>(pos).size()
+                                                 : perft(pos, depth - 1, hash);
+                    pos.undo_move(divide[k].move);
+                }
+            });
+
+        for (size_t i = 0; i < threads.num_threads(); ++i)
+            threads.wait_on_thread(i);
+    }
+
+    uint64_t nodes = 0;
+    for (const auto& item : divide)
+        nodes += item.nodes;
+
+    return nodes;
+}
+
+}  // namespace Stockfish::Benchmark
@@ -0,0 +1,79 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef PERFT_H_INCLUDED
+#define PERFT_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sf_types.h"
+
+namespace Stockfish {
+
+class ThreadPool;
+
+namespace Benchmark {
+
+// Karuah Chess - node count of a root move, in the order the moves were generated
+struct PerftDivideItem {
+    Move     move;
+    uint64_t nodes;
+};
+
+// Karuah Chess - perft node counts by position key and depth, shared by all
+// perft threads. Entries are written without locking. The key is stored xor
+// the data so an entry torn by a concurrent write reads as a miss.
+class PerftHash {
+   public:
+    explicit PerftHash(size_t mbSize);
+
+    bool probe(Key key, Depth depth, uint64_t& nodes) const;
+    void store(Key key, Depth depth, uint64_t nodes);
+
+   private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    size_t                   count;
+    std::unique_ptr<Entry[]> table;
+
+    size_t index(Key key, Depth depth) const;
+};
+
+// Counts the leaf nodes of the position at the given depth. The root moves are
+// split across the threads of the pool.
+uint64_t perft(ThreadPool&                   threads,
+               const std::string&            fen,
+               Depth                         depth,
+               bool                          isChess960,
+               PerftHash*                    hash,
+               std::vector<PerftDivideItem>& divide);
+
+}  // namespace Benchmark
+
+}  // namespace Stockfish
+
+#endif  // #ifndef PERFT_H_INCLUDED
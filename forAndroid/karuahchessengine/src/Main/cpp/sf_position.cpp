@@ -254,6 +254,54 @@ Position& Position::set(const string& fenStr, bool isChess960, StateInfo* si) {
 }
 
 
+// Initializes the position from a piece placement and state, the same way
+// as set() does for a FEN string. Castling rights without a king and rook
+// on their starting squares are dropped.
+Position& Position::set(const PositionSetup& setup, StateInfo* si) {
+
+    std::memset(this, 0, sizeof(Position));
+    std::memset(si, 0, sizeof(StateInfo));
+    st = si;
+
+    for (Square s = SQ_A1; s <= SQ_H8; ++s)
+        if (setup.board[s] != NO_PIECE)
+            put_piece(setup.board[s], s);
+
+    sideToMove = setup.sideToMove;
+
+    for (CastlingRights cr : {WHITE_OO, WHITE_OOO, BLACK_OO, BLACK_OOO})
+    {
+        if (!(setup.castlingRights & cr))
+            continue;
+
+        Color  c   = cr & WHITE_CASTLING ? WHITE : BLACK;
+        Square rsq = relative_square(c, cr & KING_SIDE ? SQ_H1 : SQ_A1);
+
+        if (piece_on(relative_square(c, SQ_E1)) == make_piece(c, KING)
+            && piece_on(rsq) == make_piece(c, ROOK))
+            set_castling_right(c, rsq);
+    }
+
+    // En passant square is kept only when a capture is possible, as in set()
+    st->epSquare = SQ_NONE;
+    if (is_ok(setup.epSquare) && rank_of(setup.epSquare) == relative_rank(sideToMove, RANK_6)
+        && (pawn_attacks_bb(~sideToMove, setup.epSquare) & pieces(sideToMove, PAWN))
+        && (pieces(~sideToMove, PAWN) & (setup.epSquare + pawn_push(~sideToMove)))
+        && !(pieces() & (setup.epSquare | (setup.epSquare + pawn_push(sideToMove)))))
+        st->epSquare = setup.epSquare;
+
+    st->rule50 = setup.rule50;
+    gamePly    = std::max(2 * (setup.fullMove - 1), 0) + (sideToMove == BLACK);
+
+    chess960 = false;
+    set_state();
+
+    assert(pos_is_ok());
+
+    return *this;
+}
+
+
 // Helper function used to set castling
 // rights given the corresponding color and the rook starting square.
 void Position::set_castling_right(Color c, Square rfrom) {
@@ -274,7 +322,7 @@ void Position::set_castling_right(Color c, Square rfrom) {
 
 
 // Sets king attacks to detect if a move gives check
-void Position::set_check_info() const {
+BITBOARD_CLONES void Position::set_check_info() const {
 
     update_slider_blockers(WHITE);
     update_slider_blockers(BLACK);
@@ -443,7 +491,7 @@ Bitboard Position::attackers_to(Square s, Bitboard occupied) const {
 
 
 // Tests whether a pseudo-legal move is legal
-bool Position::legal(Move m) const {
+BITBOARD_CLONES bool Position::legal(Move m) const {
 
     assert(m.is_ok());
 
@@ -504,7 +552,7 @@ bool Position::legal(Move m) const {
 // Takes a random move and tests whether the move is
 // pseudo-legal. It is used to validate moves from TT that can be corrupted
 // due to SMP concurrent access or hash position key aliasing.
-bool Position::pseudo_legal(const Move m) const {
+BITBOARD_CLONES bool Position::pseudo_legal(const Move m) const {
 
     Color  us   = sideToMove;
     Square from = m.from_sq();
@@ -571,7 +619,7 @@ bool Position::pseudo_legal(const Move m) const {
 
 
 // Tests whether a pseudo-legal move gives a check
-bool Position::gives_check(Move m) const {
+BITBOARD_CLONES bool Position::gives_check(Move m) const {
 
     assert(m.is_ok());
     assert(color_of(moved_piece(m)) == sideToMove);
@@ -986,7 +1034,7 @@ Key Position::key_after(Move m) const {
 // Tests if the SEE (Static Exchange Evaluation)
 // value of move is greater or equal to the given threshold. We'll use an
 // algorithm similar to alpha-beta pruning with a null window.
-bool Position::see_ge(Move m, int threshold) const {
+BITBOARD_CLONES bool Position::see_ge(Move m, int threshold) const {
 
     assert(m.is_ok());
 
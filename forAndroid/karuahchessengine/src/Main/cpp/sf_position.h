@@ -73,6 +73,19 @@ struct StateInfo {
 using StateListPtr = std::unique_ptr<std::deque<StateInfo>>;
 
 
+// Piece placement and state used to set up a position directly, without
+// writing and parsing a FEN string. Castling rights are for the standard
+// rook squares only.
+struct PositionSetup {
+    Piece          board[SQUARE_NB];
+    Color          sideToMove;
+    CastlingRights castlingRights;
+    Square         epSquare;
+    int            rule50;
+    int            fullMove;
+};
+
+
 // Position class stores information regarding the board representation as
 // pieces, side to move, hash keys, castling info, etc. Important methods are
 // do_move() and undo_move(), used by the search to update node info when
@@ -88,6 +101,7 @@ class Position {
     // FEN string input/output
     Position&   set(const std::string& fenStr, bool isChess960, StateInfo* si);
     Position&   set(const std::string& code, Color c, StateInfo* si);
+    Position&   set(const PositionSetup& setup, StateInfo* si);
     std::string fen() const;
 
     // Position representation
@@ -31,6 +31,7 @@
 #include <list>
 #include <ratio>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include "sf_evaluate.h"
@@ -163,8 +164,10 @@ void Search::Worker::start_searching() {
     // the UCI protocol states that we shouldn't print the best move before the
     // GUI sends a "stop" or "ponderhit" command. We therefore simply wait here
     // until the GUI sends one of those commands.
+    // Karuah Chess - sleep rather than spin, a ponder search can wait here for
+    // as long as the user is thinking
     while (!threads.stop && (main_manager()->ponder || limits.infinite))
-    {}  // Busy wait for a stop or a ponder reset
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
     // Stop the threads if not already stopped (also raise the stop if
     // "ponderhit" just reset threads.ponder)
@@ -503,6 +506,8 @@ void Search::Worker::clear() {
     refreshTable.clear(networks[numaAccessToken]);
 }
 
+void Search::Worker::clear_refresh_table() { refreshTable.clear(networks[numaAccessToken]); }
+
 
 // Main search function for both PV and non-PV nodes
 template<NodeType nodeType>
@@ -891,8 +896,21 @@ moves_loop:  // When in check, search starts here
 
         if (rootNode && is_mainthread() && nodes > 10000000)
         {
-            main_manager()->updates.onIter(
-              {depth, UCIEngine::move(move, pos.is_chess960()), moveCount + thisThread->pvIdx});
+            // Karuah Chess - publish a record when there is a queue
+            if (const auto& infoQueue = main_manager()->updates.infoQueue)
+            {
+                InfoRecord record{};
+                record.kind     = InfoRecord::Iteration;
+                record.chess960 = pos.is_chess960();
+                record.depth    = depth;
+                record.multiPV  = int(moveCount + thisThread->pvIdx);
+                record.pvLength = 1;
+                record.pv[0]    = move;
+                infoQueue->push(record);
+            }
+            else
+                main_manager()->updates.onIter(
+                  {depth, UCIEngine::move(move, pos.is_chess960()), moveCount + thisThread->pvIdx});
         }
         if (PvNode)
             (ss + 1)->pv = nullptr;
@@ -2001,6 +2019,39 @@ void SearchManager::pv(Search::Worker&           worker,
             && ((!rootMoves[i].scoreLowerbound && !rootMoves[i].scoreUpperbound) || isExact))
             syzygy_extend_pv(worker.options, worker.limits, pos, rootMoves[i], v);
 
+        // Karuah Chess - publish a record instead, the strings are made by the consumer
+        if (updates.infoQueue)
+        {
+            InfoRecord record{};
+            const auto [wdlW, wdlD, wdlL] = UCIEngine::wdl_values(v, pos);
+
+            record.kind     = InfoRecord::Full;
+            record.bound    = isExact                       ? InfoRecord::Exact
+                            : rootMoves[i].scoreLowerbound ? InfoRecord::Lower
+                            : rootMoves[i].scoreUpperbound ? InfoRecord::Upper
+                                                            : InfoRecord::Exact;
+            record.chess960 = pos.is_chess960();
+            record.depth    = d;
+            record.selDepth = rootMoves[i].selDepth;
+            record.multiPV  = int(i + 1);
+            record.score    = {v, pos};
+            record.wdl[0]   = wdlW;
+            record.wdl[1]   = wdlD;
+            record.wdl[2]   = wdlL;
+
+            TimePoint time  = tm.elapsed_time() + 1;
+            record.timeMs   = time;
+            record.nodes    = nodes;
+            record.nps      = nodes * 1000 / time;
+            record.tbHits   = tbHits;
+            record.hashfull = tt.hashfull();
+            record.pvLength = int(std::min(rootMoves[i].pv.size(), size_t(InfoRecord::MaxPV)));
+            std::copy_n(rootMoves[i].pv.begin(), record.pvLength, record.pv);
+
+            updates.infoQueue->push(record);
+            continue;
+        }
+
         std::string pv;
         for (Move m : rootMoves[i].pv)
             pv += UCIEngine::move(m, pos.is_chess960()) + " ";
@@ -180,6 +180,42 @@ struct InfoIteration {
     size_t           currmovenumber;
 };
 
+// Karuah Chess - the search information as a fixed size record. Nothing is
+// formatted on the search thread, the moves are kept as Move values and the
+// consumer makes any strings it needs.
+struct InfoRecord {
+    enum Kind : std::uint8_t {
+        Full,       // a principal variation, as InfoFull
+        Iteration   // the root move being searched, as InfoIteration
+    };
+
+    enum Bound : std::uint8_t {
+        Exact,
+        Lower,
+        Upper
+    };
+
+    static constexpr int MaxPV = 64;
+
+    Kind   kind;
+    Bound  bound;
+    bool   chess960;
+    int    depth;
+    int    selDepth;
+    int    multiPV;  // the current move number for Iteration
+    Score  score;
+    int    wdl[3];   // win, draw and loss in per mille
+    size_t timeMs;
+    size_t nodes;
+    size_t nps;
+    size_t tbHits;
+    int    hashfull;
+    int    pvLength;
+    Move   pv[MaxPV];  // the current move for Iteration
+};
+
+class InfoQueue: public SpscRing<InfoRecord, 64> {};
+
 // Skill structure is used to implement strength limit. If we have a UCI_Elo,
 // we convert it to an appropriate skill level, anchored to the Stash engine.
 // This method is based on a fit of the Elo results for games played between
@@ -227,6 +263,10 @@ class SearchManager: public ISearchManager {
         UpdateFull     onUpdateFull;
         UpdateIter     onIter;
         UpdateBestmove onBestmove;
+
+        // Karuah Chess - when set, the information is pushed as records instead of
+        // calling onUpdateFull and onIter, so a slow consumer cannot stall the search
+        std::shared_ptr<InfoQueue> infoQueue;
     };
 
 
@@ -273,6 +313,9 @@ class Worker {
     // Reset histories, usually before a new game.
     void clear();
 
+    // Karuah Chess - clears the accumulator refresh table, after a network is swapped in
+    void clear_refresh_table();
+
     // Called when the program receives the UCI 'go' command.
     // It searches from the root position and outputs the "bestmove".
     void start_searching();
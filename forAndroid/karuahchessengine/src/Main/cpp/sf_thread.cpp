@@ -222,6 +222,16 @@ void ThreadPool::clear() {
     main_manager()->tm.clear();
 }
 
+// Karuah Chess - clears the accumulator refresh tables of the workers, used when
+// a network is swapped in between searches
+void ThreadPool::clear_refresh_tables() {
+    for (auto&& th : threads)
+        th->run_custom_job([&th]() { th->worker->clear_refresh_table(); });
+
+    for (auto&& th : threads)
+        th->wait_for_search_finished();
+}
+
 void ThreadPool::run_on_thread(size_t threadId, std::function<void()> f) {
     assert(threads.size() > threadId);
     threads[threadId]->run_custom_job(std::move(f));
@@ -134,6 +134,7 @@ class ThreadPool {
     void   wait_on_thread(size_t threadId);
     size_t num_threads() const;
     void   clear();
+    void   clear_refresh_tables();
     void   set(const NumaConfig& numaConfig,
                Search::SharedState,
                const Search::SearchManager::UpdateContext&);
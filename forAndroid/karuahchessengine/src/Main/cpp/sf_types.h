@@ -35,6 +35,9 @@
 //
 // -DUSE_PEXT    | Add runtime support for use of pext asm-instruction. Works
 //               | only in 64-bit mode and requires hardware with pext support.
+//
+// -DNO_BITBOARD_CLONES | Do not select popcnt, pext and the BMI instructions at
+//               | runtime on x86 (see BITBOARD_CLONES below).
 
     #include <cassert>
     #include <cstdint>
@@ -82,6 +85,34 @@
         #define pext(b, m) 0
     #endif
 
+// Karuah Chess - x86 builds with GCC or Clang that do not already target BMI2
+// select the bit manipulation instructions at runtime. The functions that make
+// the most use of popcount(), lsb() and msb() are marked BITBOARD_CLONES and are
+// compiled for several instruction sets, and the loader picks the version for
+// the processor. Slider attacks use pext when Bitboards::init() finds a fast
+// pext instruction. Define NO_BITBOARD_CLONES to build a single version.
+    #if defined(__GNUC__) && defined(__ELF__) && (defined(__x86_64__) || defined(__i386__)) \
+      && !defined(__BMI2__) && !defined(NO_BITBOARD_CLONES)
+        #define USE_BITBOARD_CLONES
+        #if defined(__x86_64__)
+            #define USE_RUNTIME_PEXT
+        #endif
+        #if defined(__x86_64__) && defined(USE_POPCNT)
+            #define BITBOARD_CLONES __attribute__((target_clones("default", "arch=x86-64-v3")))
+        #elif defined(__x86_64__)
+            #define BITBOARD_CLONES \
+                __attribute__((target_clones("default", "popcnt", "arch=x86-64-v3")))
+        #elif !defined(USE_POPCNT)
+            #define BITBOARD_CLONES __attribute__((target_clones("default", "popcnt")))
+        #else
+            #undef USE_BITBOARD_CLONES
+        #endif
+    #endif
+
+    #if !defined(BITBOARD_CLONES)
+        #define BITBOARD_CLONES
+    #endif
+
 namespace Stockfish {
 
     #ifdef USE_POPCNT
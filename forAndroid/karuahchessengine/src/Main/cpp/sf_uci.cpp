@@ -22,19 +22,27 @@
 #include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <deque>
+#include <iostream>
+#include <map>
 #include <optional>
 #include <sstream>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "sf_benchmark.h"
 #include "sf_engine.h"
 #include "sf_movegen.h"
+#include "sf_perft.h"
 #include "sf_position.h"
 #include "sf_score.h"
 #include "sf_search.h"
 #include "sf_types.h"
 #include "sf_ucioption.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "perft.h"
 
 namespace Stockfish {
 
@@ -47,19 +55,94 @@ struct overload: Ts... {
 template<typename... Ts>
 overload(Ts...) -> overload<Ts...>;
 
-UCIEngine::UCIEngine() :
-    engine()
+UCIEngine::UCIEngine(std::shared_ptr<const Eval::NNUE::SharedNetworks> sharedNetworks) :
+    engine(std::move(sharedNetworks))
 {
 
     engine.get_options().add_info_listener([](const std::optional<std::string>& str) {        
     });
 
+    // Karuah Chess - search output is only printed when driven by UCI commands, see loop()
+    engine.set_on_iter([](const auto&) {});
+    engine.set_on_update_no_moves([](const auto&) {});
+    engine.set_on_update_full([](const auto&) {});
+    
+    // Karuah Chess - removed set_on_bestmove as setting this in search.cpp instead    
+}
+
+void UCIEngine::loop(const std::string& command) {
+
+    std::string token, cmd = command;
+
+    engine.get_options().add_info_listener([](const std::optional<std::string>& str) {
+        if (str.has_value())
+            sync_cout << "info string " << *str << sync_endl;
+    });
+
     engine.set_on_iter([](const auto& i) { on_iter(i); });
     engine.set_on_update_no_moves([](const auto& i) { on_update_no_moves(i); });
     engine.set_on_update_full(
       [this](const auto& i) { on_update_full(i, engine.get_options()["UCI_ShowWDL"]); });
-    
-    // Karuah Chess - removed set_on_bestmove as setting this in search.cpp instead    
+    engine.set_on_bestmove([](const auto& bm, const auto& p, const auto&) { on_bestmove(bm, p); });
+
+    // Karuah Chess - the output goes to the callbacks, not the queue of a search session
+    engine.set_info_queue(nullptr);
+
+    do
+    {
+        if (command.empty()
+            && !getline(std::cin, cmd))  // Wait for an input or an end-of-file (EOF) indication
+            cmd = "quit";
+
+        std::istringstream is(cmd);
+
+        token.clear();  // Avoid a stale if getline() returns nothing or a blank line
+        is >> std::skipws >> token;
+
+        if (token == "quit" || token == "stop")
+            engine.stop();
+
+        // The GUI sends 'ponderhit' to tell that the user has played the expected move.
+        // So, 'ponderhit' is sent if pondering was done on the same move that the user
+        // has played. The search should continue, but should also switch from pondering
+        // to the normal search.
+        else if (token == "ponderhit")
+            engine.set_ponderhit(false);
+
+        else if (token == "uci")
+            sync_cout << "id name " << engine_info(true) << "\n"
+                      << engine.get_options() << "\nuciok" << sync_endl;
+
+        else if (token == "setoption")
+            setoption(is);
+        else if (token == "go")
+            go(is);
+        else if (token == "position")
+            position(is);
+        else if (token == "ucinewgame")
+            engine.search_clear();
+        else if (token == "isready")
+            sync_cout << "readyok" << sync_endl;
+
+        // Add custom non-UCI commands, mainly for debugging purposes.
+        // These commands must not be used during a search!
+        else if (token == "bench")
+        {
+            Benchmark::BenchResult result = bench(is, true);
+
+            std::cerr << "\n==========================="           //
+                      << "\nTotal time (ms) : " << result.elapsed  //
+                      << "\nNodes searched  : " << result.nodes    //
+                      << "\nNodes/second    : " << result.nps << std::endl;
+        }
+        else if (token == "perft")
+            perft_check(is);
+        else if (!token.empty() && token[0] != '#')
+            sync_cout << "Unknown command: '" << cmd << "'." << sync_endl;
+
+    } while (token != "quit" && command.empty());  // The command argument is one-shot
+
+    engine.wait_for_search_finished();
 }
 
 Search::LimitsType UCIEngine::parse_limits(std::istream& is) {
@@ -101,6 +184,180 @@ Search::LimitsType UCIEngine::parse_limits(std::istream& is) {
     return limits;
 }
 
+Benchmark::BenchResult UCIEngine::bench(std::istream& args, bool verbose) {
+    std::string            token;
+    uint64_t               num, cnt = 1;
+    uint64_t               nodesSearched = 0;
+    Benchmark::BenchResult result;
+    const auto&            options = engine.get_options();
+
+    engine.wait_for_search_finished();
+
+    // Karuah Chess - the node counts depend on the networks used
+    engine.wait_for_networks();
+    report_engine_errors();
+
+    engine.set_on_update_full([&](const auto& i) {
+        nodesSearched = i.nodes;
+        if (verbose)
+            on_update_full(i, options["UCI_ShowWDL"]);
+    });
+    engine.set_on_bestmove([&](const auto& bm, const auto& p, const auto&) {
+        if (verbose)
+            on_bestmove(bm, p);
+    });
+
+    // Karuah Chess - the nodes are counted by the callback, not the queue of a search session
+    engine.set_info_queue(nullptr);
+
+    std::vector<std::string> list = Benchmark::setup_bench(engine.fen(), args);
+
+    num = count_if(list.begin(), list.end(),
+                   [](const std::string& s) { return s.find("go ") == 0; });
+
+    TimePoint elapsed = now();
+
+    for (const auto& cmd : list)
+    {
+        std::istringstream is(cmd);
+        is >> std::skipws >> token;
+
+        if (token == "go")
+        {
+            if (verbose)
+                std::cerr << "\nPosition: " << cnt++ << '/' << num << " (" << engine.fen() << ")"
+                          << std::endl;
+
+            Search::LimitsType limits = parse_limits(is);
+
+            if (limits.perft)
+                nodesSearched = perft(limits);
+            else
+            {
+                engine.go(limits);
+                engine.wait_for_search_finished();
+            }
+
+            result.nodes += nodesSearched;
+            result.positions++;
+            nodesSearched = 0;
+        }
+        else if (token == "setoption")
+            setoption(is);
+        else if (token == "position")
+            position(is);
+        else if (token == "ucinewgame")
+        {
+            engine.search_clear();  // search_clear may take a while
+            elapsed = now();
+        }
+    }
+
+    result.elapsed = now() - elapsed + 1;  // Ensure positivity to avoid a 'divide by zero'
+    result.nps     = 1000 * result.nodes / result.elapsed;
+
+    // Reset the callbacks, to not capture dangling references. The output is
+    // printed only when driven by UCI commands.
+    if (verbose)
+    {
+        engine.set_on_update_full(
+          [this](const auto& i) { on_update_full(i, engine.get_options()["UCI_ShowWDL"]); });
+        engine.set_on_bestmove(
+          [](const auto& bm, const auto& p, const auto&) { on_bestmove(bm, p); });
+    }
+    else
+    {
+        engine.set_on_update_full([](const auto&) {});
+        engine.set_on_bestmove([](const auto&, const auto&, const auto&) {});
+    }
+
+    return result;
+}
+
+void UCIEngine::go(std::istringstream& is) {
+
+    Search::LimitsType limits = parse_limits(is);
+
+    report_engine_errors();
+
+    if (limits.perft)
+        perft(limits);
+    else
+        engine.go(limits);
+}
+
+void UCIEngine::report_engine_errors() {
+    std::vector<int> errors = KaruahChess::Engine::engineErr.list();
+    for (; reportedErrors < errors.size(); ++reportedErrors)
+        sync_cout << "info string engine error " << errors[reportedErrors] << sync_endl;
+}
+
+uint64_t UCIEngine::perft(const Search::LimitsType& limits) {
+
+    std::vector<Benchmark::PerftDivideItem> divide;
+
+    TimePoint elapsed = now();
+    uint64_t  nodes   = engine.perft(engine.fen(), limits.perft, 0, divide);
+    elapsed           = now() - elapsed + 1;
+
+    bool chess960 = engine.get_options()["UCI_Chess960"];
+    for (const auto& item : divide)
+        sync_cout << move(item.move, chess960) << ": " << item.nodes << sync_endl;
+
+    sync_cout << "\nNodes searched: " << nodes << "\nNodes/second: " << 1000 * nodes / elapsed
+              << "\n" << sync_endl;
+
+    return nodes;
+}
+
+// Karuah Chess - runs perft on the current position with the Stockfish and the
+// Karuah Chess move generators, and prints the root moves where they differ.
+// The arguments are the depth and an optional perft hash size in MB.
+void UCIEngine::perft_check(std::istream& args) {
+
+    Depth  depth  = 5;
+    size_t hashMB = 0;
+    if (!(args >> depth))
+        depth = 5;
+    args >> hashMB;
+
+    const std::string fen = engine.fen();
+
+    std::vector<Benchmark::PerftDivideItem> sfDivide;
+    TimePoint                               sfElapsed = now();
+    uint64_t sfNodes = engine.perft(fen, depth, hashMB, sfDivide);
+    sfElapsed        = now() - sfElapsed + 1;
+
+    StateListPtr states(new std::deque<StateInfo>(1));
+    Position     pos;
+    pos.set(fen, false, &states->back());
+    KaruahChess::BitBoard board;
+    KaruahChess::Engine::fromPosition(pos, board);
+
+    std::vector<KaruahChess::Perft::PerftDivideItem> kcDivide;
+    TimePoint                                        kcElapsed = now();
+    uint64_t kcNodes = KaruahChess::Perft::Divide(engine, board, depth, hashMB, kcDivide);
+    kcElapsed        = now() - kcElapsed + 1;
+
+    // Compare the root moves by their UCI notation
+    std::map<std::string, std::pair<uint64_t, uint64_t>> moves;
+    for (const auto& item : sfDivide)
+        moves[move(item.move, false)].first = item.nodes;
+    for (const auto& item : kcDivide)
+        moves[KaruahChess::Perft::MoveUCI(item)].second = item.nodes;
+
+    for (const auto& [m, nodes] : moves)
+        if (nodes.first != nodes.second)
+            sync_cout << m << ": stockfish " << nodes.first << " karuahchess " << nodes.second
+                      << sync_endl;
+
+    sync_cout << "\nStockfish   nodes: " << sfNodes << " time (ms): " << sfElapsed
+              << " nodes/second: " << 1000 * sfNodes / sfElapsed
+              << "\nKaruahChess nodes: " << kcNodes << " time (ms): " << kcElapsed
+              << " nodes/second: " << 1000 * kcNodes / kcElapsed
+              << (sfNodes == kcNodes ? "\nmatch\n" : "\nMISMATCH\n") << sync_endl;
+}
+
 void UCIEngine::setoption(std::istringstream& is) {
     engine.wait_for_search_finished();
     engine.get_options().setoption(is);
@@ -186,12 +443,18 @@ int UCIEngine::to_cp(Value v, const Position& pos) {
 std::string UCIEngine::wdl(Value v, const Position& pos) {
     std::stringstream ss;
 
+    const auto [wdl_w, wdl_d, wdl_l] = wdl_values(v, pos);
+    ss << wdl_w << " " << wdl_d << " " << wdl_l;
+
+    return ss.str();
+}
+
+std::array<int, 3> UCIEngine::wdl_values(Value v, const Position& pos) {
     int wdl_w = win_rate_model(v, pos);
     int wdl_l = win_rate_model(-v, pos);
     int wdl_d = 1000 - wdl_w - wdl_l;
-    ss << wdl_w << " " << wdl_d << " " << wdl_l;
 
-    return ss.str();
+    return {wdl_w, wdl_d, wdl_l};
 }
 
 std::string UCIEngine::square(Square s) {
@@ -236,8 +499,26 @@ Move UCIEngine::to_move(const Position& pos, std::string str) {
     return Move::none();
 }
 
+std::string UCIEngine::format_score(const Score& s) {
+    constexpr int TB_CP = 20000;
+    const auto    format =
+      overload{[](Score::Mate mate) -> std::string {
+                   auto m = (mate.plies > 0 ? (mate.plies + 1) : mate.plies) / 2;
+                   return std::string("mate ") + std::to_string(m);
+               },
+               [](Score::Tablebase tb) -> std::string {
+                   return std::string("cp ")
+                        + std::to_string((tb.win ? TB_CP - tb.plies : -TB_CP - tb.plies));
+               },
+               [](Score::InternalUnits units) -> std::string {
+                   return std::string("cp ") + std::to_string(units.value);
+               }};
+
+    return s.visit(format);
+}
+
 void UCIEngine::on_update_no_moves(const Engine::InfoShort& info) {
-    
+    sync_cout << "info depth " << info.depth << " score " << format_score(info.score) << sync_endl;
 }
 
 void UCIEngine::on_update_full(const Engine::InfoFull& info, bool showWDL) {
@@ -246,8 +527,8 @@ void UCIEngine::on_update_full(const Engine::InfoFull& info, bool showWDL) {
     ss << "info";
     ss << " depth " << info.depth                 //
         << " seldepth " << info.selDepth           //
-        << " multipv " << info.multiPV;             //
-       
+        << " multipv " << info.multiPV             //
+        << " score " << format_score(info.score);  //
 
     if (showWDL)
         ss << " wdl " << info.wdl;
@@ -261,6 +542,8 @@ void UCIEngine::on_update_full(const Engine::InfoFull& info, bool showWDL) {
        << " tbhits " << info.tbHits      //
        << " time " << info.timeMs        //
        << " pv " << info.pv;             //        
+
+    sync_cout << ss.str() << sync_endl;
 }
 
 void UCIEngine::on_iter(const Engine::InfoIter& info) {
@@ -270,6 +553,15 @@ void UCIEngine::on_iter(const Engine::InfoIter& info) {
     ss << " depth " << info.depth                     //
        << " currmove " << info.currmove               //
        << " currmovenumber " << info.currmovenumber;  //        
+
+    sync_cout << ss.str() << sync_endl;
+}
+
+void UCIEngine::on_bestmove(std::string_view bestmove, std::string_view ponder) {
+    sync_cout << "bestmove " << bestmove;
+    if (!ponder.empty())
+        std::cout << " ponder " << ponder;
+    std::cout << sync_endl;
 }
 
 
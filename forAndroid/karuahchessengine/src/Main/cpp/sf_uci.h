@@ -19,11 +19,14 @@
 #ifndef UCI_H_INCLUDED
 #define UCI_H_INCLUDED
 
+#include <array>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "sf_benchmark.h"
 #include "sf_engine.h"
 #include "sf_misc.h"
 #include "sf_search.h"
@@ -38,12 +41,22 @@ using Value = int;
 
 class UCIEngine {
    public:
-    UCIEngine();
-    
+    // Karuah Chess - the engine evaluates with the shared networks
+    explicit UCIEngine(std::shared_ptr<const Eval::NNUE::SharedNetworks> sharedNetworks);
+
+    // Karuah Chess - reads UCI commands from stdin, or runs a single command when one is given
+    void loop(const std::string& command = "");
+
+    // Karuah Chess - searches the bench positions, printing the search output when verbose
+    Benchmark::BenchResult bench(std::istream& args, bool verbose = false);
+
     static int         to_cp(Value v, const Position& pos);    
+    static std::string format_score(const Score& s);
     static std::string square(Square s);
     static std::string move(Move m, bool chess960);
     static std::string wdl(Value v, const Position& pos);
+    // Karuah Chess - the win, draw and loss chances in per mille
+    static std::array<int, 3> wdl_values(Value v, const Position& pos);
     static std::string to_lower(std::string str);
     static Move        to_move(const Position& pos, std::string str);
 
@@ -56,12 +69,21 @@ class UCIEngine {
 
    private:        
         
+    void          go(std::istringstream& is);
+    uint64_t      perft(const Search::LimitsType&);
+    void          perft_check(std::istream& args);
     void          position(std::istringstream& is);
     void          setoption(std::istringstream& is);    
 
+    // Karuah Chess - prints the engine errors added since the last call, such as the
+    // big network failing to load in the background
+    void   report_engine_errors();
+    size_t reportedErrors = 0;
+
     static void on_update_no_moves(const Engine::InfoShort& info);
     static void on_update_full(const Engine::InfoFull& info, bool showWDL);
     static void on_iter(const Engine::InfoIter& info);    
+    static void on_bestmove(std::string_view bestmove, std::string_view ponder);
 };
 
 }  // namespace Stockfish
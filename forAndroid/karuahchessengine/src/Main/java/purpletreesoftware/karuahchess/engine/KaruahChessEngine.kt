@@ -27,442 +27,185 @@ class KaruahChessEngine(pContext: Context?, pActivityID: Int) {
     private val id: Int
     private val activityID: Int
     private val kce: KaruahChessEngineC
-    private val kce1: KaruahChessEngineC1
 
     fun getBoard() : String {
-        if (activityID == 0) {
-            return kce.getBoard(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getBoard(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getBoard(id)
     }
 
     fun getOccupiedByColour(pColour: Int): ULong {
-        if (activityID == 0) {
-            return kce.getOccupiedByColour(pColour, id).toULong()
-        }
-        else if (activityID == 1) {
-            return kce1.getOccupiedByColour(pColour, id).toULong()
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getOccupiedByColour(pColour, id).toULong()
 
     }
 
     fun getState(): String {
-        if (activityID == 0) {
-            return kce.getState(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getState(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getState(id)
     }
 
 
     fun setBoard(pBoardFENString : String) {
-        if (activityID == 0) {
-            kce.setBoard(pBoardFENString, id)
-        }
-        else if (activityID == 1) {
-            kce1.setBoard(pBoardFENString, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setBoard(pBoardFENString, id)
     }
 
     fun setState(pBoardStateString : String) {
-        if (activityID == 0) {
-            kce.setState(pBoardStateString, id)
-        }
-        else if (activityID == 1) {
-            kce1.setState(pBoardStateString, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setState(pBoardStateString, id)
     }
 
     fun getBoardArray(): ULongArray {
-        if (activityID == 0) {
-            return kce.getBoardArrayL(id).toULongArray()
-        }
-        else if (activityID == 1) {
-            return kce1.getBoardArrayL(id).toULongArray()
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getBoardArrayL(id).toULongArray()
     }
 
     fun getStateArray() : IntArray {
-        if (activityID == 0) {
-            return kce.getStateArray(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateArray(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateArray(id)
     }
 
     fun setBoardArray(pBoardArray : ULongArray) {
-        if (activityID == 0) {
-            kce.setBoardArrayL(pBoardArray.toLongArray(), id)
-        }
-        else if (activityID == 1) {
-            kce1.setBoardArrayL(pBoardArray.toLongArray(), id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setBoardArrayL(pBoardArray.toLongArray(), id)
     }
 
     fun setStateArray(pStateArray : IntArray) {
-        if (activityID == 0) {
-            kce.setStateArray(pStateArray, id)
-        }
-        else if (activityID == 1) {
-            kce1.setStateArray(pStateArray, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setStateArray(pStateArray, id)
+    }
+
+    /**
+     * Makes the move which leads to the next board, so the engine keeps the move history it
+     * needs to detect repetitions. Returns false, leaving the board unchanged, if there is no such move.
+     */
+    fun replayMove(pNextBoardArray : ULongArray, pNextStateArray : IntArray): Boolean {
+        return kce.replayMoveL(pNextBoardArray.toLongArray(), pNextStateArray, id)
     }
 
     fun setStateWhiteClockOffset(pOffset : Int) {
-        if (activityID == 0) {
-            kce.setStateWhiteClockOffset(pOffset, id)
-        }
-        else if (activityID == 1) {
-            kce1.setStateWhiteClockOffset(pOffset, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setStateWhiteClockOffset(pOffset, id)
     }
 
     fun setStateBlackClockOffset(pOffset : Int) {
-        if (activityID == 0) {
-            kce.setStateBlackClockOffset(pOffset, id)
-        }
-        else if (activityID == 1) {
-            kce1.setStateBlackClockOffset(pOffset, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setStateBlackClockOffset(pOffset, id)
     }
 
     fun getStateWhiteClockOffset(): Int {
-        if (activityID == 0) {
-            return kce.getStateWhiteClockOffset(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateWhiteClockOffset(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateWhiteClockOffset(id)
     }
 
     fun getStateBlackClockOffset(): Int {
-        if (activityID == 0) {
-            return kce.getStateBlackClockOffset(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateBlackClockOffset(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateBlackClockOffset(id)
     }
 
     fun reset(){
-        if (activityID == 0) {
-            kce.reset(id)
-        }
-        else if (activityID == 1) {
-            kce1.reset(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.reset(id)
     }
 
 
     fun cancelSearch() {
-        if (activityID == 0) {
-            kce.cancelSearch()
-        }
-        else if (activityID == 1) {
-            kce1.cancelSearch()
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.cancelSearch(id)
     }
 
     fun getSpin(pIndex: Int): Int {
-        if (activityID == 0) {
-            return kce.getSpin(pIndex, id)
-        }
-        else if (activityID == 1) {
-            return kce1.getSpin(pIndex, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getSpin(pIndex, id)
     }
 
     fun getStateActiveColour(): Int {
-        if (activityID == 0) {
-            return kce.getStateActiveColour(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateActiveColour(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateActiveColour(id)
     }
 
     fun setStateActiveColour(pColour: Int) {
-        if (activityID == 0) {
-            kce.setStateActiveColour(pColour, id)
-        }
-        else if (activityID == 1) {
-            kce1.setStateActiveColour(pColour, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setStateActiveColour(pColour, id)
     }
 
     fun getStateGameStatus(): Int {
-        if (activityID == 0) {
-            return kce.getStateGameStatus(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateGameStatus(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateGameStatus(id)
     }
 
     fun setStateGameStatus(pStatus: Int) {
-        if (activityID == 0) {
-            kce.setStateGameStatus(pStatus, id)
-        }
-        else if (activityID == 1) {
-            kce1.setStateGameStatus(pStatus, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        kce.setStateGameStatus(pStatus, id)
+    }
+
+    fun getGameStatus(): Int {
+        return kce.getGameStatus(id)
     }
 
     fun getStateFullMoveCount(): Int {
-        if (activityID == 0) {
-            return kce.getStateFullMoveCount(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateFullMoveCount(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateFullMoveCount(id)
     }
 
     fun getStateCastlingAvailability(): Int {
-        if (activityID == 0) {
-            return kce.getStateCastlingAvailability(id)
-        }
-        else if (activityID == 1) {
-            return kce1.getStateCastlingAvailability(id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getStateCastlingAvailability(id)
     }
 
     fun getKingIndex(pColour: Int): Int {
-        if (activityID == 0) {
-            return kce.getKingIndex(pColour, id)
-        }
-        else if (activityID == 1) {
-            return kce1.getKingIndex(pColour, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getKingIndex(pColour, id)
     }
 
     fun isKingCheck(pColour: Int): Boolean {
-        if (activityID == 0) {
-            return kce.isKingCheck(pColour, id)
-        }
-        else if (activityID == 1) {
-            return kce1.isKingCheck(pColour, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.isKingCheck(pColour, id)
     }
 
     fun getPotentialMove(pSqIndex: Int): ULong {
-        if (activityID == 0) {
-            return kce.getPotentialMoveL(pSqIndex, id).toULong()
-        }
-        else if (activityID == 1) {
-            return kce1.getPotentialMoveL(pSqIndex, id).toULong()
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getPotentialMoveL(pSqIndex, id).toULong()
+    }
+
+    fun getLegalMove(pSqIndex: Int): ULong {
+        return kce.getLegalMoveL(pSqIndex, id).toULong()
     }
 
     fun move(pFromIndex: Int, pToIndex: Int, pPawnPromotionPiece: Int, pValidateEnabled: Boolean, pCommit: Boolean): MoveResult {
-        if (activityID == 0) {
-            return kce.move(pFromIndex, pToIndex, pPawnPromotionPiece, pValidateEnabled, pCommit, id)
-        }
-        else if (activityID == 1) {
-            return kce1.move(pFromIndex, pToIndex, pPawnPromotionPiece, pValidateEnabled, pCommit, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.move(pFromIndex, pToIndex, pPawnPromotionPiece, pValidateEnabled, pCommit, id)
     }
 
     fun arrange(pFromIndex: Int, pToIndex: Int): MoveResult {
-        if (activityID == 0) {
-            return kce.arrange(pFromIndex, pToIndex, id)
-        }
-        else if (activityID == 1) {
-            return kce1.arrange(pFromIndex, pToIndex, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.arrange(pFromIndex, pToIndex, id)
     }
 
     fun arrangeUpdate(pFen: Char, pToIndex: Int): MoveResult {
-        if (activityID == 0) {
-            return kce.arrangeUpdate(pFen, pToIndex, id)
-        }
-        else if (activityID == 1) {
-            return kce1.arrangeUpdate(pFen, pToIndex, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.arrangeUpdate(pFen, pToIndex, id)
     }
 
     fun isPawnPromotion(pFromIndex: Int, pToIndex: Int): Boolean {
-        if (activityID == 0) {
-            return kce.isPawnPromotion(pFromIndex, pToIndex, id)
-        }
-        else if (activityID == 1) {
-            return kce1.isPawnPromotion(pFromIndex, pToIndex, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.isPawnPromotion(pFromIndex, pToIndex, id)
     }
 
     fun findFromIndex(pToIndex: Int, pSpin: Int, pValidFromIndexes: IntArray?): Int {
-        if (activityID == 0) {
-            return kce.findFromIndex(pToIndex, pSpin, pValidFromIndexes, id)
-        }
-        else if (activityID == 1) {
-            return kce1.findFromIndex(pToIndex, pSpin, pValidFromIndexes, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.findFromIndex(pToIndex, pSpin, pValidFromIndexes, id)
     }
 
     fun getSpinFromPieceName(pPieceName: String): Int {
-        if (activityID == 0) {
-            return kce.getSpinFromPieceName(pPieceName)
-        }
-        else if (activityID == 1) {
-            return kce1.getSpinFromPieceName(pPieceName)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getSpinFromPieceName(pPieceName)
     }
 
     fun getPieceNameFromChar(pFENChar: Char): String {
-        if (activityID == 0) {
-            return kce.getPieceNameFromChar(pFENChar)
-        }
-        else if (activityID == 1) {
-            return kce1.getPieceNameFromChar(pFENChar)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getPieceNameFromChar(pFENChar)
     }
 
     fun getFENCharFromSpin(pSpin: Int): Char {
-        if (activityID == 0) {
-            return kce.getFENCharFromSpin(pSpin)
-        }
-        else if (activityID == 1) {
-            return kce1.getFENCharFromSpin(pSpin)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.getFENCharFromSpin(pSpin)
     }
 
 
     fun searchStart(pSearchOptions: SearchOptions): SearchResult {
-        if (activityID == 0) {
-            return kce.searchStart(pSearchOptions, id)
-        }
-        else if (activityID == 1) {
-            return kce1.searchStart(pSearchOptions, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.searchStart(pSearchOptions, id)
+    }
+
+    /**
+     * Searches the reply expected to the last engine move while the user is thinking.
+     * The next searchStart continues from it if the user plays that reply.
+     */
+    fun ponderStart(pSearchOptions: SearchOptions): Boolean {
+        return kce.ponderStart(pSearchOptions, id)
+    }
+
+    /**
+     * Searches the replies to the moves the user is most likely to play, in the background.
+     * The next searchStart is answered straight away if the user plays one of them.
+     */
+    fun speculateStart(pSearchOptions: SearchOptions) {
+        kce.speculateStart(pSearchOptions, id)
     }
 
     fun setStateCastlingAvailability(pCastlingAvailability: Int, pColour: Int): Boolean {
-        if (activityID == 0) {
-            return kce.setStateCastlingAvailability(pCastlingAvailability, pColour, id)
-        }
-        else if (activityID == 1) {
-            return kce1.setStateCastlingAvailability(pCastlingAvailability, pColour, id)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.setStateCastlingAvailability(pCastlingAvailability, pColour, id)
     }
 
     fun cleanup(pId: Int) {
-        if (activityID == 0) {
-            return kce.cleanup(pId)
-        }
-        else if (activityID == 1) {
-            return kce1.cleanup(pId)
-        }
-        else {
-            throw Exception("Invalid activity id.")
-        }
+        return kce.cleanup(pId)
     }
 
     /**
@@ -475,26 +218,23 @@ class KaruahChessEngine(pContext: Context?, pActivityID: Int) {
     init {
         activityID = pActivityID
         kce = KaruahChessEngineC()
-        kce1 = KaruahChessEngineC1()
 
         // Load asset manager if not loaded previously
         if (KaruahChessEngine.assetMgr == null) {
             KaruahChessEngine.assetMgr = pContext?.getResources()?.getAssets();
         }
 
+        // Directory for the converted NNUE networks, these are recreated if the cache is cleared
+        if (KaruahChessEngine.nnueCacheDir.isEmpty()) {
+            KaruahChessEngine.nnueCacheDir = pContext?.cacheDir?.absolutePath?.let { "$it/nnue" } ?: ""
+        }
+
         // Use id to keep track of all engine objects that are loaded
         id = KaruahChessEngine.idCounter
+        // The engine objects of an activity share an engine context, the contexts of all the
+        // activities share the NNUE networks
         KaruahChessEngine.assetMgr?.let {
-            if (activityID == 0) {
-                kce.initialise(it, id)
-            }
-            else if (activityID == 1) {
-                kce1.initialise(it, id)
-            }
-            else {
-                throw Exception("Invalid activity id.")
-            }
-
+            kce.initialise(it, KaruahChessEngine.nnueCacheDir, activityID, id)
         }
         KaruahChessEngine.idCounter++
     }
@@ -502,6 +242,7 @@ class KaruahChessEngine(pContext: Context?, pActivityID: Int) {
     companion object {
         private var idCounter = 0
         private var assetMgr: AssetManager? = null
+        private var nnueCacheDir: String = ""
     }
 
 }
\ No newline at end of file
@@ -19,6 +19,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "bitboard.h"
 #include "helper.h"
 #include "piecepattern.h"
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -61,6 +62,8 @@ namespace KaruahChess {
 		_positions[11] = &_positionWhiteQueen;
 		_positions[12] = &_positionWhiteKing;
 
+		std::fill(std::begin(_mailbox), std::end(_mailbox), int8_t(0));
+
 		Hash = 0ULL;
 		HashPawn = 0ULL;
 		_hashMaterial = 0ULL;
@@ -73,16 +76,34 @@ namespace KaruahChess {
 		StateWhiteClockOffset = 0;
 		StateBlackClockOffset = 0;
 		ReturnMessage = "";
-		MoveSAN = "";
+		LastMoveSAN = MoveSANInfo();
 
 		MoveData[0] = -1;
 		MoveData[1] = -1;
 		MoveData[2] = 0;
 		MoveData[3] = 0;
+
+		_attackPathReady = false;
+		_attackPathRebuild = true;
+		_attackPathDirty = 0ULL;
+		_attackPathEnpassantIndex = -1;
+		std::fill(std::begin(_attackPath), std::end(_attackPath), 0uLL);
+		std::fill(std::begin(_attackXRayPath), std::end(_attackXRayPath), 0uLL);
+		std::fill(std::begin(_nonAttackPawnPath), std::end(_nonAttackPawnPath), 0uLL);
+		std::fill(std::begin(_castlePath), std::end(_castlePath), 0uLL);
+		std::fill(std::begin(_potentialAttackPawnPath), std::end(_potentialAttackPawnPath), 0uLL);
+		_whitePos = 0ULL;
+		_blackPos = 0ULL;
+		_whiteCheckers = 0ULL;
+		_blackCheckers = 0ULL;
+		_whitePinned = 0ULL;
+		_blackPinned = 0ULL;
+		_enpassantLegal = 0ULL;
 	}
 
 	/// <summary>
-	/// Updates all the attack paths
+	/// Updates all the attack paths. When the paths have been calculated before, only the pieces
+	/// affected by squares changed since the last calculation are recalculated.
 	/// </summary>
 	void BitBoard::CalculateAttackPaths()
 	{
@@ -90,27 +111,61 @@ namespace KaruahChess {
 		_blackPos = _positionBlackPawn | _positionBlackKnight | _positionBlackBishop | _positionBlackRook | _positionBlackQueen | _positionBlackKing;
 		uint64_t blockers = _whitePos | _blackPos;
 
-		// 0 to 63 are squares.
-		int whiteKingIndex = -1;
-		int blackKingIndex = -1;
-		_whiteAttack = 0ULL;
-		_blackAttack = 0ULL;
-		_whitePotentialAttackPawn = 0ULL;
-		_blackPotentialAttackPawn = 0ULL;
-		_whiteAttackXRayBlackKing = 0ULL;
-		_blackAttackXRayWhiteKing = 0ULL;
-
-		uint64_t sqMask = 0ULL;
-
-		uint64_t occupiedScan = blockers;
+		uint64_t occupiedScan = 0ULL;
 		int sqIndex = 0;
 		int posScan = 0;
 
-		// Zero attack path
-		std::fill(std::begin(_attackPath), std::end(_attackPath), 0uLL);
-		std::fill(std::begin(_nonAttackPawnPath), std::end(_nonAttackPawnPath), 0uLL);
-		std::fill(std::begin(_castlePath), std::end(_castlePath), 0uLL);
-		std::fill(std::begin(_potentialAttackPawnPath), std::end(_potentialAttackPawnPath), 0uLL);
+		if (_attackPathRebuild)
+		{
+			// Zero attack path
+			std::fill(std::begin(_attackPath), std::end(_attackPath), 0uLL);
+			std::fill(std::begin(_attackXRayPath), std::end(_attackXRayPath), 0uLL);
+			std::fill(std::begin(_nonAttackPawnPath), std::end(_nonAttackPawnPath), 0uLL);
+			std::fill(std::begin(_castlePath), std::end(_castlePath), 0uLL);
+			std::fill(std::begin(_potentialAttackPawnPath), std::end(_potentialAttackPawnPath), 0uLL);
+
+			occupiedScan = blockers;
+		}
+		else
+		{
+			uint64_t dirty = _attackPathDirty;
+
+			// Kings are not treated as blockers so that paths which x-ray through a king are also found
+			uint64_t rayBlockers = blockers & ~(_positionWhiteKing | _positionBlackKing);
+			uint64_t diagonalSliders = _positionWhiteBishop | _positionWhiteQueen | _positionBlackBishop | _positionBlackQueen;
+			uint64_t horizontalVerticalSliders = _positionWhiteRook | _positionWhiteQueen | _positionBlackRook | _positionBlackQueen;
+
+			// Pieces on the changed squares
+			occupiedScan = dirty & blockers;
+
+			uint64_t dirtyScan = dirty;
+			while (dirtyScan > 0)
+			{
+				posScan = helper::BitScanForward(dirtyScan);
+				dirtyScan ^= 1uLL << posScan;
+				sqIndex = (63 - posScan);
+
+				_attackPath[sqIndex] = 0ULL;
+				_attackXRayPath[sqIndex] = 0ULL;
+				_nonAttackPawnPath[sqIndex] = 0ULL;
+				_potentialAttackPawnPath[sqIndex] = 0ULL;
+				_castlePath[sqIndex] = 0ULL;
+
+				// Sliders with a ray crossing the changed square
+				occupiedScan |= helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & rayBlockers) * helper::DiagonalMagic[sqIndex]) >> 52] & diagonalSliders;
+				occupiedScan |= helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & rayBlockers) * helper::HorizontalVerticalMagic[sqIndex]) >> 52] & horizontalVerticalSliders;
+			}
+
+			// Pawns which can move to, capture on or take en passant beside a changed square
+			uint64_t pawns = _positionWhitePawn | _positionBlackPawn;
+			if (StateEnpassantIndex != _attackPathEnpassantIndex) {
+				occupiedScan |= pawns;
+			}
+			else {
+				uint64_t pawnZone = dirty | (dirty << 1) | (dirty >> 1) | (dirty << 7) | (dirty >> 7) | (dirty << 8) | (dirty >> 8) | (dirty << 9) | (dirty >> 9) | (dirty << 16) | (dirty >> 16);
+				occupiedScan |= pawnZone & pawns;
+			}
+		}
 
 		while (occupiedScan > 0)
 		{
@@ -118,95 +173,44 @@ namespace KaruahChess {
 			occupiedScan ^= 1uLL << posScan;
 			sqIndex = (63 - posScan);
 
-			sqMask = helper::BITMASK >> sqIndex;
-			_attackPath[sqIndex] = 0ULL;
-			_nonAttackPawnPath[sqIndex] = 0ULL;
+			CalculateSquareAttackPath(sqIndex, blockers);
+		}
 
-			if ((sqMask & _positionWhitePawn) > 0)
-			{
-				_nonAttackPawnPath[sqIndex] = PiecePattern::PawnMove<WHITEPIECE>(sqIndex, blockers);
-				_potentialAttackPawnPath[sqIndex] = PiecePattern::PawnPotentialAttack<WHITEPIECE>(sqIndex);
-				_attackPath[sqIndex] = PiecePattern::PawnAttack<WHITEPIECE>(sqIndex, blockers);
-				_attackPath[sqIndex] |= PiecePattern::PawnEnpassant<WHITEPIECE>(sqIndex, StateEnpassantIndex, _positionWhitePawn, _positionBlackPawn);
-				_whiteAttack |= _attackPath[sqIndex];
-				_whitePotentialAttackPawn |= _potentialAttackPawnPath[sqIndex];
-			}
-			else if ((sqMask & _positionWhiteBishop) > 0)
-			{
-				_attackPath[sqIndex] = helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & blockers) * helper::DiagonalMagic[sqIndex]) >> 52];
-				_whiteAttack |= _attackPath[sqIndex];
-				_whiteAttackXRayBlackKing |= helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & (blockers & ~_positionBlackKing)) * helper::DiagonalMagic[sqIndex]) >> 52];
+		// Combine the paths of each side. Doing the kings at the end
+		_whiteAttack = 0ULL;
+		_blackAttack = 0ULL;
+		_whitePotentialAttackPawn = 0ULL;
+		_blackPotentialAttackPawn = 0ULL;
+		_whiteAttackXRayBlackKing = 0ULL;
+		_blackAttackXRayWhiteKing = 0ULL;
 
-			}
-			else if ((sqMask & _positionWhiteQueen) > 0)
-			{
-				// Queen pattern is the bishop pattern xor with rook pattern
-				_attackPath[sqIndex] = (helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & blockers) * helper::DiagonalMagic[sqIndex]) >> 52] ^
-					helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & blockers) * helper::HorizontalVerticalMagic[sqIndex]) >> 52]);
-				_whiteAttack |= _attackPath[sqIndex];
-				_whiteAttackXRayBlackKing |= (helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & (blockers & ~_positionBlackKing)) * helper::DiagonalMagic[sqIndex]) >> 52] ^
-					helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & (blockers & ~_positionBlackKing)) * helper::HorizontalVerticalMagic[sqIndex]) >> 52]);
-			}
-			else if ((sqMask & _positionWhiteRook) > 0)
-			{
-				_attackPath[sqIndex] = helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & blockers) * helper::HorizontalVerticalMagic[sqIndex]) >> 52];
-				_whiteAttack |= _attackPath[sqIndex];
-				_whiteAttackXRayBlackKing |= helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & (blockers & ~_positionBlackKing)) * helper::HorizontalVerticalMagic[sqIndex]) >> 52];
+		uint64_t pieceScan = _whitePos & ~_positionWhiteKing;
+		while (pieceScan > 0)
+		{
+			posScan = helper::BitScanForward(pieceScan);
+			pieceScan ^= 1uLL << posScan;
+			sqIndex = (63 - posScan);
 
-			}
-			else if ((sqMask & _positionWhiteKing) > 0)
-			{
-				whiteKingIndex = sqIndex;  // Doing the kings at the end
-			}
-			else if ((sqMask & _positionWhiteKnight) > 0)
-			{
-				_attackPath[sqIndex] = helper::KnightMove[sqIndex];
-				_whiteAttack |= _attackPath[sqIndex];
-			}
-			else if ((sqMask & _positionBlackPawn) > 0)
-			{
-				_nonAttackPawnPath[sqIndex] = PiecePattern::PawnMove<BLACKPIECE>(sqIndex, blockers);
-				_potentialAttackPawnPath[sqIndex] = PiecePattern::PawnPotentialAttack<BLACKPIECE>(sqIndex);
-				_attackPath[sqIndex] = PiecePattern::PawnAttack<BLACKPIECE>(sqIndex, blockers);
-				_attackPath[sqIndex] |= PiecePattern::PawnEnpassant<BLACKPIECE>(sqIndex, StateEnpassantIndex, _positionWhitePawn, _positionBlackPawn);
-				_blackAttack |= _attackPath[sqIndex];
-				_blackPotentialAttackPawn |= _potentialAttackPawnPath[sqIndex];
-			}
-			else if ((sqMask & _positionBlackBishop) > 0)
-			{
-				_attackPath[sqIndex] = helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & blockers) * helper::DiagonalMagic[sqIndex]) >> 52];
-				_blackAttack |= _attackPath[sqIndex];
-				_blackAttackXRayWhiteKing |= helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & (blockers & ~_positionWhiteKing)) * helper::DiagonalMagic[sqIndex]) >> 52];
-			}
-			else if (((sqMask & _positionBlackQueen)) > 0)
-			{
-				// Queen pattern is the bishop pattern xor with rook pattern
-				_attackPath[sqIndex] = (helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & blockers) * helper::DiagonalMagic[sqIndex]) >> 52] ^
-					helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & blockers) * helper::HorizontalVerticalMagic[sqIndex]) >> 52]);
-				_blackAttack |= _attackPath[sqIndex];
-				_blackAttackXRayWhiteKing |= (helper::DiagonalMove[sqIndex][((helper::DiagonalRay[sqIndex] & (blockers & ~_positionWhiteKing)) * helper::DiagonalMagic[sqIndex]) >> 52] ^
-					helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & (blockers & ~_positionWhiteKing)) * helper::HorizontalVerticalMagic[sqIndex]) >> 52]);
+			_whiteAttack |= _attackPath[sqIndex];
+			_whiteAttackXRayBlackKing |= _attackXRayPath[sqIndex];
+			_whitePotentialAttackPawn |= _potentialAttackPawnPath[sqIndex];
+		}
 
-			}
-			else if ((sqMask & _positionBlackRook) > 0)
-			{
-				_attackPath[sqIndex] = helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & blockers) * helper::HorizontalVerticalMagic[sqIndex]) >> 52];
-				_blackAttack |= _attackPath[sqIndex];
-				_blackAttackXRayWhiteKing |= helper::HorizontalVerticalMove[sqIndex][((helper::HorizontalVerticalRay[sqIndex] & (blockers & ~_positionWhiteKing)) * helper::HorizontalVerticalMagic[sqIndex]) >> 52];
-			}
-			else if ((sqMask & _positionBlackKing) > 0)
-			{
-				blackKingIndex = sqIndex;
-			}
-			else if ((sqMask & _positionBlackKnight) > 0)
-			{
-				_attackPath[sqIndex] = helper::KnightMove[sqIndex];
-				_blackAttack |= _attackPath[sqIndex];
-			}
+		pieceScan = _blackPos & ~_positionBlackKing;
+		while (pieceScan > 0)
+		{
+			posScan = helper::BitScanForward(pieceScan);
+			pieceScan ^= 1uLL << posScan;
+			sqIndex = (63 - posScan);
 
+			_blackAttack |= _attackPath[sqIndex];
+			_blackAttackXRayWhiteKing |= _attackXRayPath[sqIndex];
+			_blackPotentialAttackPawn |= _potentialAttackPawnPath[sqIndex];
 		}
 
 		// Calculate the king attack paths
+		int whiteKingIndex = KingIndex<WHITEPIECE>();
+		int blackKingIndex = KingIndex<BLACKPIECE>();
 		if (whiteKingIndex > -1 && blackKingIndex > -1) {
 			_attackPath[whiteKingIndex] = helper::KingMove[whiteKingIndex] & ~(_blackAttack | _blackAttackXRayWhiteKing | _blackPotentialAttackPawn | helper::KingMove[blackKingIndex]);
 			_attackPath[blackKingIndex] = helper::KingMove[blackKingIndex] & ~(_whiteAttack | _whiteAttackXRayBlackKing | _whitePotentialAttackPawn | helper::KingMove[whiteKingIndex]);
@@ -215,8 +219,19 @@ namespace KaruahChess {
 
 
 			// Add in castling moves
-			_castlePath[whiteKingIndex] |= PiecePattern::KingCastle<WHITEPIECE>(whiteKingIndex, _whitePos, _blackPos, _positionWhiteRook, _blackAttack, _blackPotentialAttackPawn, StateCastlingAvailability);
-			_castlePath[blackKingIndex] |= PiecePattern::KingCastle<BLACKPIECE>(blackKingIndex, _whitePos, _blackPos, _positionBlackRook, _whiteAttack, _whitePotentialAttackPawn, StateCastlingAvailability);
+			_castlePath[whiteKingIndex] = PiecePattern::KingCastle<WHITEPIECE>(whiteKingIndex, _whitePos, _blackPos, _positionWhiteRook, _blackAttack, _blackPotentialAttackPawn, StateCastlingAvailability);
+			_castlePath[blackKingIndex] = PiecePattern::KingCastle<BLACKPIECE>(blackKingIndex, _whitePos, _blackPos, _positionBlackRook, _whiteAttack, _whitePotentialAttackPawn, StateCastlingAvailability);
+		}
+		else {
+			if (whiteKingIndex > -1) {
+				_attackPath[whiteKingIndex] = 0ULL;
+				_castlePath[whiteKingIndex] = 0ULL;
+			}
+
+			if (blackKingIndex > -1) {
+				_attackPath[blackKingIndex] = 0ULL;
+				_castlePath[blackKingIndex] = 0ULL;
+			}
 		}
 
 
@@ -234,17 +249,220 @@ namespace KaruahChess {
 		_hashMaterial ^= _positionBlackQueen ? RandomBoardArray[BLACK_QUEEN_INDEX_64 + (popcount(_positionBlackQueen) - 1)] : 0ULL;
 		_hashMaterial ^= _positionBlackKing ? RandomBoardArray[BLACK_KING_INDEX_64 + (popcount(_positionBlackKing) - 1)] : 0ULL;
 
+		// Checks and pins on each king
+		_enpassantLegal = 0ULL;
+		CalculateCheckPin<WHITEPIECE>(whiteKingIndex, blockers);
+		CalculateCheckPin<BLACKPIECE>(blackKingIndex, blockers);
+
+		_attackPathEnpassantIndex = StateEnpassantIndex;
+		_attackPathDirty = 0ULL;
+		_attackPathRebuild = false;
 		_attackPathReady = true;
 	}
 
 
+	/// <summary>
+	/// Calculates the pieces checking the king of the specified colour, the pieces pinned to it
+	/// and whether an en passant capture by the colour leaves the king in check.
+	/// </summary>
+	/// <param name="pKingIndex"></param>
+	/// <param name="pBlockers"></param>
+	template<int Colour> void BitBoard::CalculateCheckPin(const int pKingIndex, const uint64_t pBlockers)
+	{
+		uint64_t checkers = 0ULL;
+		uint64_t pinned = 0ULL;
+
+		if (pKingIndex > -1)
+		{
+			uint64_t usPos = Colour == WHITEPIECE ? _whitePos : _blackPos;
+			uint64_t themPos = Colour == WHITEPIECE ? _blackPos : _whitePos;
+			uint64_t themKnight = GetOccupiedBySpin<-Colour>(KNIGHT_SPIN);
+			uint64_t themPawn = GetOccupiedBySpin<-Colour>(PAWN_SPIN);
+			uint64_t themDiagonal = GetOccupiedBySpin<-Colour>(BISHOP_SPIN) | GetOccupiedBySpin<-Colour>(QUEEN_SPIN);
+			uint64_t themHorizontalVertical = GetOccupiedBySpin<-Colour>(ROOK_SPIN) | GetOccupiedBySpin<-Colour>(QUEEN_SPIN);
+
+			checkers = (helper::KnightMove[pKingIndex] & themKnight) |
+				(PiecePattern::PawnPotentialAttack<Colour>(pKingIndex) & themPawn) |
+				(helper::DiagonalMove[pKingIndex][((helper::DiagonalRay[pKingIndex] & pBlockers) * helper::DiagonalMagic[pKingIndex]) >> 52] & themDiagonal) |
+				(helper::HorizontalVerticalMove[pKingIndex][((helper::HorizontalVerticalRay[pKingIndex] & pBlockers) * helper::HorizontalVerticalMagic[pKingIndex]) >> 52] & themHorizontalVertical);
+
+			// Sliders which attack the king when only the opponent pieces block, pin a single piece between
+			uint64_t snipers = (helper::DiagonalMove[pKingIndex][((helper::DiagonalRay[pKingIndex] & themPos) * helper::DiagonalMagic[pKingIndex]) >> 52] & themDiagonal) |
+				(helper::HorizontalVerticalMove[pKingIndex][((helper::HorizontalVerticalRay[pKingIndex] & themPos) * helper::HorizontalVerticalMagic[pKingIndex]) >> 52] & themHorizontalVertical);
+			while (snipers > 0)
+			{
+				int posScan = helper::BitScanForward(snipers);
+				snipers ^= 1uLL << posScan;
+				uint64_t between = helper::BetweenMask[pKingIndex][63 - posScan] & pBlockers;
+				if (between > 0 && (between & (between - 1)) == 0 && (between & usPos) > 0) pinned |= between;
+			}
+
+			// En passant removes two pieces from a line so the king is tested with the resulting blockers
+			if (StateEnpassantIndex > -1 && GetSpin(StateEnpassantIndex) == -Colour * PAWN_SPIN)
+			{
+				uint64_t enpassantMask = helper::BITMASK >> StateEnpassantIndex;
+				uint64_t targetMask = Colour == WHITEPIECE ? enpassantMask << 8 : enpassantMask >> 8;
+				uint64_t pawnScan = GetOccupiedBySpin<Colour>(PAWN_SPIN) & ((enpassantMask << 1) | (enpassantMask >> 1)) & helper::RowMask[StateEnpassantIndex];
+				while (pawnScan > 0)
+				{
+					int posScan = helper::BitScanForward(pawnScan);
+					pawnScan ^= 1uLL << posScan;
+					uint64_t fromMask = 1uLL << posScan;
+					uint64_t blockers = (pBlockers & ~(fromMask | enpassantMask)) | targetMask;
+
+					uint64_t attackers = (helper::KnightMove[pKingIndex] & themKnight) |
+						(PiecePattern::PawnPotentialAttack<Colour>(pKingIndex) & themPawn & ~enpassantMask) |
+						(helper::DiagonalMove[pKingIndex][((helper::DiagonalRay[pKingIndex] & blockers) * helper::DiagonalMagic[pKingIndex]) >> 52] & themDiagonal) |
+						(helper::HorizontalVerticalMove[pKingIndex][((helper::HorizontalVerticalRay[pKingIndex] & blockers) * helper::HorizontalVerticalMagic[pKingIndex]) >> 52] & themHorizontalVertical);
+
+					if (attackers == 0) _enpassantLegal |= fromMask;
+				}
+			}
+		}
+
+		if constexpr (Colour == WHITEPIECE) {
+			_whiteCheckers = checkers;
+			_whitePinned = pinned;
+		}
+		else {
+			_blackCheckers = checkers;
+			_blackPinned = pinned;
+		}
+	}
+
 
 	/// <summary>
-	/// Gets all potential moves for a given square
+	/// Calculates the attack paths of the piece on a square. King paths are not
+	/// calculated here as they depend on the combined attacks of the other side.
+	/// </summary>
+	/// <param name="pSqIndex"></param>
+	/// <param name="pBlockers"></param>
+	void BitBoard::CalculateSquareAttackPath(const int pSqIndex, const uint64_t pBlockers)
+	{
+		uint64_t sqMask = helper::BITMASK >> pSqIndex;
+		_attackPath[pSqIndex] = 0ULL;
+		_attackXRayPath[pSqIndex] = 0ULL;
+		_nonAttackPawnPath[pSqIndex] = 0ULL;
+		_potentialAttackPawnPath[pSqIndex] = 0ULL;
+
+		if ((sqMask & _positionWhitePawn) > 0)
+		{
+			_nonAttackPawnPath[pSqIndex] = PiecePattern::PawnMove<WHITEPIECE>(pSqIndex, pBlockers);
+			_potentialAttackPawnPath[pSqIndex] = PiecePattern::PawnPotentialAttack<WHITEPIECE>(pSqIndex);
+			_attackPath[pSqIndex] = PiecePattern::PawnAttack<WHITEPIECE>(pSqIndex, pBlockers);
+			_attackPath[pSqIndex] |= PiecePattern::PawnEnpassant<WHITEPIECE>(pSqIndex, StateEnpassantIndex, _positionWhitePawn, _positionBlackPawn);
+		}
+		else if ((sqMask & _positionWhiteBishop) > 0)
+		{
+			_attackPath[pSqIndex] = helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & pBlockers) * helper::DiagonalMagic[pSqIndex]) >> 52];
+			_attackXRayPath[pSqIndex] = helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & (pBlockers & ~_positionBlackKing)) * helper::DiagonalMagic[pSqIndex]) >> 52];
+		}
+		else if ((sqMask & _positionWhiteQueen) > 0)
+		{
+			// Queen pattern is the bishop pattern xor with rook pattern
+			_attackPath[pSqIndex] = (helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & pBlockers) * helper::DiagonalMagic[pSqIndex]) >> 52] ^
+				helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & pBlockers) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52]);
+			_attackXRayPath[pSqIndex] = (helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & (pBlockers & ~_positionBlackKing)) * helper::DiagonalMagic[pSqIndex]) >> 52] ^
+				helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & (pBlockers & ~_positionBlackKing)) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52]);
+		}
+		else if ((sqMask & _positionWhiteRook) > 0)
+		{
+			_attackPath[pSqIndex] = helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & pBlockers) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52];
+			_attackXRayPath[pSqIndex] = helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & (pBlockers & ~_positionBlackKing)) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52];
+		}
+		else if ((sqMask & _positionWhiteKnight) > 0)
+		{
+			_attackPath[pSqIndex] = helper::KnightMove[pSqIndex];
+		}
+		else if ((sqMask & _positionBlackPawn) > 0)
+		{
+			_nonAttackPawnPath[pSqIndex] = PiecePattern::PawnMove<BLACKPIECE>(pSqIndex, pBlockers);
+			_potentialAttackPawnPath[pSqIndex] = PiecePattern::PawnPotentialAttack<BLACKPIECE>(pSqIndex);
+			_attackPath[pSqIndex] = PiecePattern::PawnAttack<BLACKPIECE>(pSqIndex, pBlockers);
+			_attackPath[pSqIndex] |= PiecePattern::PawnEnpassant<BLACKPIECE>(pSqIndex, StateEnpassantIndex, _positionWhitePawn, _positionBlackPawn);
+		}
+		else if ((sqMask & _positionBlackBishop) > 0)
+		{
+			_attackPath[pSqIndex] = helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & pBlockers) * helper::DiagonalMagic[pSqIndex]) >> 52];
+			_attackXRayPath[pSqIndex] = helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & (pBlockers & ~_positionWhiteKing)) * helper::DiagonalMagic[pSqIndex]) >> 52];
+		}
+		else if ((sqMask & _positionBlackQueen) > 0)
+		{
+			// Queen pattern is the bishop pattern xor with rook pattern
+			_attackPath[pSqIndex] = (helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & pBlockers) * helper::DiagonalMagic[pSqIndex]) >> 52] ^
+				helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & pBlockers) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52]);
+			_attackXRayPath[pSqIndex] = (helper::DiagonalMove[pSqIndex][((helper::DiagonalRay[pSqIndex] & (pBlockers & ~_positionWhiteKing)) * helper::DiagonalMagic[pSqIndex]) >> 52] ^
+				helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & (pBlockers & ~_positionWhiteKing)) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52]);
+		}
+		else if ((sqMask & _positionBlackRook) > 0)
+		{
+			_attackPath[pSqIndex] = helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & pBlockers) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52];
+			_attackXRayPath[pSqIndex] = helper::HorizontalVerticalMove[pSqIndex][((helper::HorizontalVerticalRay[pSqIndex] & (pBlockers & ~_positionWhiteKing)) * helper::HorizontalVerticalMagic[pSqIndex]) >> 52];
+		}
+		else if ((sqMask & _positionBlackKnight) > 0)
+		{
+			_attackPath[pSqIndex] = helper::KnightMove[pSqIndex];
+		}
+	}
+
+
+	/// <summary>
+	/// Gets all legal moves for a given square
 	/// </summary>
 	/// <param name="pSqIndex"></param>
 	/// <returns></returns>
 	uint64_t BitBoard::GetPotentialMove(const int pSqIndex)
+	{
+		uint64_t potential = GetPseudoLegalMove(pSqIndex);
+		uint64_t sqMask = helper::BITMASK >> pSqIndex;
+
+		// King paths already exclude attacked squares
+		if (potential == 0ULL || (sqMask & (_positionWhiteKing | _positionBlackKing)) > 0ULL) return potential;
+
+		int kingIndex;
+		uint64_t checkers;
+		uint64_t pinned;
+		if ((_whitePos & sqMask) > 0ULL) {
+			kingIndex = KingIndex<WHITEPIECE>();
+			checkers = _whiteCheckers;
+			pinned = _whitePinned;
+		}
+		else {
+			kingIndex = KingIndex<BLACKPIECE>();
+			checkers = _blackCheckers;
+			pinned = _blackPinned;
+		}
+
+		if (kingIndex < 0) return potential;
+
+		// En passant capture was tested when the attack paths were calculated
+		uint64_t enpassant = 0ULL;
+		if (StateEnpassantIndex > -1 && (sqMask & (_positionWhitePawn | _positionBlackPawn)) > 0ULL) {
+			uint64_t enpassantMask = helper::BITMASK >> StateEnpassantIndex;
+			enpassant = potential & ((sqMask & _whitePos) > 0ULL ? enpassantMask << 8 : enpassantMask >> 8) & ~(_whitePos | _blackPos);
+			potential &= ~enpassant;
+			if ((sqMask & _enpassantLegal) == 0ULL) enpassant = 0ULL;
+		}
+
+		// Moves must capture or block a single checker. Only the king can move when in double check.
+		if (checkers > 0ULL) {
+			if ((checkers & (checkers - 1)) == 0ULL) potential &= checkers | helper::BetweenMask[kingIndex][63 - helper::BitScanForward(checkers)];
+			else potential = 0ULL;
+		}
+
+		// Pinned pieces can only move along the line to the king
+		if ((pinned & sqMask) > 0ULL) potential &= helper::LineMask[kingIndex][pSqIndex];
+
+		return potential | enpassant;
+	}
+
+
+	/// <summary>
+	/// Gets all moves for a given square without checking whether the king is left in check
+	/// </summary>
+	/// <param name="pSqIndex"></param>
+	/// <returns></returns>
+	uint64_t BitBoard::GetPseudoLegalMove(const int pSqIndex)
 	{
 		if (!_attackPathReady) CalculateAttackPaths();
 
@@ -294,6 +512,166 @@ namespace KaruahChess {
 
 	}
 
+	/// <summary>
+	/// Makes a move without any validation and updates the board state. The information
+	/// needed to reverse the move is stored in pUndo.
+	/// </summary>
+	void BitBoard::MakeMove(const int pFromIndex, const int pToIndex, const helper::PawnPromotionEnum pPawnPromotionPiece, MoveUndo& pUndo)
+	{
+		int fromSpin = GetSpin(pFromIndex);
+		int toSpin = GetSpin(pToIndex);
+
+		// Store original values
+		pUndo.fromIndex = pFromIndex;
+		pUndo.toIndex = pToIndex;
+		pUndo.fromSpin = fromSpin;
+		pUndo.toSpin = toSpin;
+		pUndo.enpassantCaptureIndex = -1;
+		pUndo.enpassantCaptureSpin = 0;
+		pUndo.rookFromIndex = -1;
+		pUndo.rookToIndex = -1;
+		pUndo.rookSpin = 0;
+		pUndo.activeColour = StateActiveColour;
+		pUndo.castlingAvailability = StateCastlingAvailability;
+		pUndo.enpassantIndex = StateEnpassantIndex;
+		pUndo.halfMoveCount = StateHalfMoveCount;
+		pUndo.fullMoveCount = StateFullMoveCount;
+		pUndo.hash = Hash;
+		pUndo.hashPawn = HashPawn;
+
+		// Record the move and the position before it
+		MoveHistoryItem historyItem;
+		historyItem.positionKey = PositionKey();
+		bool promotion = (fromSpin == helper::WHITE_PAWN_SPIN && pToIndex <= 7) || (fromSpin == helper::BLACK_PAWN_SPIN && pToIndex >= 56);
+		historyItem.move = uint16_t(pFromIndex | (pToIndex << 6) | (promotion ? (int)pPawnPromotionPiece << 12 : 0));
+		historyItem.castlingAvailability = int8_t(StateCastlingAvailability);
+		historyItem.enpassantIndex = int8_t(StateEnpassantIndex);
+		_moveHistory.push_back(historyItem);
+
+		// Do the move
+		Update(pFromIndex, 0);
+		Update(pToIndex, fromSpin);
+
+		// Pawn promotion
+		if ((fromSpin == helper::WHITE_PAWN_SPIN && pToIndex >= 0 && pToIndex <= 7) || (fromSpin == helper::BLACK_PAWN_SPIN && pToIndex >= 56 && pToIndex <= 63))
+		{
+			Update(pToIndex, (int)pPawnPromotionPiece * StateActiveColour);
+		}
+
+		// En passant take
+		if ((fromSpin == helper::WHITE_PAWN_SPIN && (pToIndex + 8) == StateEnpassantIndex) || (fromSpin == helper::BLACK_PAWN_SPIN && (pToIndex - 8) == StateEnpassantIndex))
+		{
+			pUndo.enpassantCaptureIndex = StateEnpassantIndex;
+			pUndo.enpassantCaptureSpin = GetSpin(StateEnpassantIndex);
+			Update(StateEnpassantIndex, 0);
+		}
+
+		// Castle the rook
+		bool castle = false;
+		if ((fromSpin == helper::WHITE_KING_SPIN && pFromIndex == 60) || (fromSpin == helper::BLACK_KING_SPIN && pFromIndex == 4))
+		{
+			int rookFromSqIndex = helper::CastleIndex[pToIndex][0];
+			int rookToSqIndex = helper::CastleIndex[pToIndex][1];
+
+			if (rookFromSqIndex > -1 && rookToSqIndex > -1)
+			{
+				pUndo.rookFromIndex = rookFromSqIndex;
+				pUndo.rookToIndex = rookToSqIndex;
+				pUndo.rookSpin = GetSpin(rookFromSqIndex);
+				Update(rookToSqIndex, pUndo.rookSpin);
+				Update(rookFromSqIndex, 0);
+				castle = true;
+			}
+		}
+
+		// Update EnPassant potential
+		int distance = pFromIndex - pToIndex;
+		if ((distance == 16 || distance == -16) && (fromSpin == helper::WHITE_PAWN_SPIN || fromSpin == helper::BLACK_PAWN_SPIN))
+		{
+			StateEnpassantIndex = pToIndex;
+		}
+		else
+		{
+			StateEnpassantIndex = -1;
+		}
+
+		// Increment the full move count after blacks move
+		if (StateActiveColour == helper::BLACKPIECE)
+		{
+			StateFullMoveCount += 1;
+		}
+
+		// Increment half move count if no piece was captured or a pawn was not advanced. Used for fifty move rule.
+		if (toSpin != 0 || fromSpin == helper::WHITE_PAWN_SPIN || fromSpin == helper::BLACK_PAWN_SPIN)
+		{
+			StateHalfMoveCount = 0;
+		}
+		else
+		{
+			StateHalfMoveCount += 1;
+		}
+
+		// Change the turn, as this turn is now complete
+		StateActiveColour *= -1;
+
+		// Update castling availability
+		if (fromSpin == helper::WHITE_ROOK_SPIN && pFromIndex == 63) StateCastlingAvailability = StateCastlingAvailability & 0b111101;
+		else if (fromSpin == helper::WHITE_ROOK_SPIN && pFromIndex == 56) StateCastlingAvailability = StateCastlingAvailability & 0b111110;
+		else if (fromSpin == helper::BLACK_ROOK_SPIN && pFromIndex == 7) StateCastlingAvailability = StateCastlingAvailability & 0b110111;
+		else if (fromSpin == helper::BLACK_ROOK_SPIN && pFromIndex == 0) StateCastlingAvailability = StateCastlingAvailability & 0b111011;
+		else if (fromSpin == helper::WHITE_KING_SPIN) StateCastlingAvailability = StateCastlingAvailability & 0b111100;
+		else if (fromSpin == helper::BLACK_KING_SPIN) StateCastlingAvailability = StateCastlingAvailability & 0b110011;
+
+		if (pToIndex == 63) StateCastlingAvailability = StateCastlingAvailability & 0b111101;
+		else if (pToIndex == 56) StateCastlingAvailability = StateCastlingAvailability & 0b111110;
+		else if (pToIndex == 7) StateCastlingAvailability = StateCastlingAvailability & 0b110111;
+		else if (pToIndex == 0) StateCastlingAvailability = StateCastlingAvailability & 0b111011;
+
+		// Update has castled flag
+		if (castle && fromSpin == helper::BLACK_KING_SPIN) StateCastlingAvailability = StateCastlingAvailability | 0b100000;
+		else if (castle && fromSpin == helper::WHITE_KING_SPIN) StateCastlingAvailability = StateCastlingAvailability | 0b010000;
+
+		// Invalidate move paths
+		_attackPathReady = false;
+	}
+
+
+	/// <summary>
+	/// Reverses a move made with MakeMove. Only the attack paths affected by the
+	/// changed squares are recalculated when next required.
+	/// </summary>
+	void BitBoard::UnmakeMove(const MoveUndo& pUndo)
+	{
+		// Reverse castle
+		if (pUndo.rookFromIndex > -1)
+		{
+			SetSpin(pUndo.rookToIndex, 0);
+			SetSpin(pUndo.rookFromIndex, pUndo.rookSpin);
+		}
+
+		// Reverse the move
+		SetSpin(pUndo.toIndex, pUndo.toSpin);
+		SetSpin(pUndo.fromIndex, pUndo.fromSpin);
+
+		// Reverse en passant
+		if (pUndo.enpassantCaptureIndex > -1)
+		{
+			SetSpin(pUndo.enpassantCaptureIndex, pUndo.enpassantCaptureSpin);
+		}
+
+		// Restore state
+		StateActiveColour = pUndo.activeColour;
+		StateCastlingAvailability = pUndo.castlingAvailability;
+		StateEnpassantIndex = pUndo.enpassantIndex;
+		StateHalfMoveCount = pUndo.halfMoveCount;
+		StateFullMoveCount = pUndo.fullMoveCount;
+		Hash = pUndo.hash;
+		HashPawn = pUndo.hashPawn;
+
+		if (!_moveHistory.empty()) _moveHistory.pop_back();
+	}
+
+
 	/// <summary>
 	/// Get board positions array and hash. pData size is 276.
 	/// </summary>
@@ -344,31 +722,34 @@ namespace KaruahChess {
 	/// <returns></returns>
 	std::string BitBoard::GetBoard()
 	{
-		std::string FENstr = "";
-		int blankCount = 0;
+		// 64 squares and 7 separators at most. Characters are written before it is known whether
+		// they are kept, so a write can land one past the placement.
+		char FENstr[64 + 7 + 1];
+		int length = 0;
 
-		for (int i = 0; i < 64; i++)
+		for (int rank = 0; rank < 8; rank++)
 		{
-			char FENChar = helper::GetFENCharFromSpin(GetSpin(i));
-
-			if (FENChar == '0') blankCount++;
-			else
+			int blankCount = 0;
+			for (int i = rank * 8; i < rank * 8 + 8; i++)
 			{
-				if (blankCount > 0) FENstr += std::to_string(blankCount);
-				blankCount = 0;
-				FENstr += FENChar;
+				int spin = _mailbox[i];
+				int occupied = spin != 0;
+
+				// Write the blank count before a piece, then the piece
+				FENstr[length] = char('0' + blankCount);
+				length += (blankCount > 0) & occupied;
+				FENstr[length] = helper::FENCharBySpin[spin + 6];
+				length += occupied;
+				blankCount = (blankCount + 1) * (1 - occupied);
 			}
 
-			if ((i + 1) % 8 == 0)
-			{
-				if (blankCount > 0) FENstr += std::to_string(blankCount);
-				blankCount = 0;
-
-				if (i < 63) FENstr += "/";
-			}
+			FENstr[length] = char('0' + blankCount);
+			length += blankCount > 0;
+			FENstr[length] = '/';
+			length += rank < 7;
 		}
 
-		return FENstr;
+		return std::string(FENstr, length);
 
 	}
 
@@ -442,6 +823,18 @@ namespace KaruahChess {
 		_positionWhiteQueen = pData[WHITE_QUEEN_INDEX];
 		_positionWhiteKing = pData[WHITE_KING_INDEX];
 
+		// Update the mailbox from the positions
+		for (int sqIndex = 0; sqIndex < 64; sqIndex++)
+		{
+			uint64_t sqMask = helper::BITMASK >> sqIndex;
+			int spin = 0;
+			for (int i = 0; i < 13; i++)
+			{
+				if (i != 6 && (*_positions[i] & sqMask) > 0) spin = i - 6;
+			}
+			_mailbox[sqIndex] = int8_t(spin);
+		}
+
 		Hash = pData[12];
 		HashPawn = pData[13];
 		_hashMaterial = pData[14];
@@ -449,7 +842,13 @@ namespace KaruahChess {
 		// Source start + offset, source end + offset + size, destination
 		std::copy(pData + 15, pData + 15 + 64, _attackPath);
 
-		_attackPathReady = pData[79] == 1uLL;
+		// X-ray paths, checks and pins are not stored in the array so all squares must be recalculated
+		_attackPathReady = false;
+		_attackPathRebuild = true;
+		_attackPathDirty = 0ULL;
+
+		// The moves leading to this board are not known
+		_moveHistory.clear();
 
 		// Source start + offset, source end + offset + size, destination
 		std::copy(pData + 80, pData + 80 + 64, _nonAttackPawnPath);
@@ -469,7 +868,7 @@ namespace KaruahChess {
 	/// <param name="pUniverseIndex"></param>
 	void BitBoard::SetBoard(const std::string pFENstr)
 	{
-		char boardArray[64] = {};
+		int8_t boardSpin[64] = {};
 
 		int sqIndex = 0;
 		for (char c : pFENstr)
@@ -477,7 +876,7 @@ namespace KaruahChess {
 			char pieceChar = char(std::tolower(c));
 			if (pieceChar == 'p' || pieceChar == 'r' || pieceChar == 'n' || pieceChar == 'b' || pieceChar == 'q' || pieceChar == 'k')
 			{
-				boardArray[sqIndex] = c;
+				boardSpin[sqIndex] = int8_t(helper::GetSpinFromChar(c));
 				sqIndex++;
 				if (sqIndex > 63) break;
 			}
@@ -498,20 +897,32 @@ namespace KaruahChess {
 			}
 		}
 
+		SetBoardSpin(boardSpin);
+	}
+
+
+	/// <summary>
+	/// Sets the board from the spin of each square. Size of pSpin is 64.
+	/// </summary>
+	/// <param name="pSpin"></param>
+	void BitBoard::SetBoardSpin(const int8_t pSpin[])
+	{
 		// Update the bitboard
 		for (int i = 0; i < 64; i++)
 		{
-			int currentSpin = GetSpin(i);
-			int newSpin = helper::GetSpinFromChar(boardArray[i]);
-			if (newSpin != currentSpin)
+			if (pSpin[i] != _mailbox[i])
 			{
-				Update(i, newSpin);
+				Update(i, pSpin[i]);
 			}
 		}
 
 
 		// Invalidate move paths
 		_attackPathReady = false;
+		_attackPathRebuild = true;
+
+		// The moves leading to this board are not known
+		_moveHistory.clear();
 
 	}
 
@@ -545,8 +956,10 @@ namespace KaruahChess {
 
 		// Set spin
 		*_positions[pSpin + 6] |= sqMask;
+		_mailbox[pSqIndex] = int8_t(pSpin);
 
-		// Invalidate move paths
+		// Invalidate move paths affected by the square
+		_attackPathDirty |= sqMask;
 		_attackPathReady = false;
 
 	}
@@ -558,27 +971,9 @@ namespace KaruahChess {
 	/// <param name="pIndex"></param>
 	int BitBoard::GetSpin(const int pIndex)
 	{
-		if (pIndex < 0) return 0;
-
-		uint64_t sqMask = helper::BITMASK >> pIndex;
-
-
-		if ((sqMask & _positionBlackPawn) > 0) return helper::BLACK_PAWN_SPIN;
-		else if ((sqMask & _positionBlackRook) > 0) return helper::BLACK_ROOK_SPIN;
-		else if ((sqMask & _positionBlackKnight) > 0) return helper::BLACK_KNIGHT_SPIN;
-		else if ((sqMask & _positionBlackBishop) > 0) return helper::BLACK_BISHOP_SPIN;
-		else if ((sqMask & _positionBlackQueen) > 0) return helper::BLACK_QUEEN_SPIN;
-		else if ((sqMask & _positionBlackKing) > 0) return helper::BLACK_KING_SPIN;
-		else if ((sqMask & _positionWhitePawn) > 0) return helper::WHITE_PAWN_SPIN;
-		else if ((sqMask & _positionWhiteRook) > 0) return helper::WHITE_ROOK_SPIN;
-		else if ((sqMask & _positionWhiteKnight) > 0) return helper::WHITE_KNIGHT_SPIN;
-		else if ((sqMask & _positionWhiteBishop) > 0) return helper::WHITE_BISHOP_SPIN;
-		else if ((sqMask & _positionWhiteQueen) > 0) return helper::WHITE_QUEEN_SPIN;
-		else if ((sqMask & _positionWhiteKing) > 0) return helper::WHITE_KING_SPIN;
-
-
-		return 0;
+		if (pIndex < 0 || pIndex > 63) return 0;
 
+		return _mailbox[pIndex];
 	}
 
 
@@ -589,24 +984,8 @@ namespace KaruahChess {
 	/// <returns></returns>
 	uint64_t BitBoard::ZobristSquareHash(const int pSqIndex)
 	{
-
-		uint64_t sqMask = helper::BITMASK >> pSqIndex;
-
-		if ((sqMask & _positionBlackPawn) > 0) return helper::RandomBoardArray[BLACK_PAWN_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionBlackRook) > 0) return helper::RandomBoardArray[BLACK_ROOK_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionBlackKnight) > 0) return helper::RandomBoardArray[BLACK_KNIGHT_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionBlackBishop) > 0) return helper::RandomBoardArray[BLACK_BISHOP_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionBlackQueen) > 0) return helper::RandomBoardArray[BLACK_QUEEN_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionBlackKing) > 0) return helper::RandomBoardArray[BLACK_KING_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhitePawn) > 0) return helper::RandomBoardArray[WHITE_PAWN_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhiteRook) > 0) return helper::RandomBoardArray[WHITE_ROOK_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhiteKnight) > 0) return helper::RandomBoardArray[WHITE_KNIGHT_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhiteBishop) > 0) return helper::RandomBoardArray[WHITE_BISHOP_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhiteQueen) > 0) return helper::RandomBoardArray[WHITE_QUEEN_INDEX_64 + pSqIndex];
-		else if ((sqMask & _positionWhiteKing) > 0) return helper::RandomBoardArray[WHITE_KING_INDEX_64 + pSqIndex];
-		else return 0uLL;
-
-
+		int spin = _mailbox[pSqIndex];
+		return spin != 0 ? helper::RandomBoardArray[helper::Index64BySpin[spin + 6] + pSqIndex] : 0uLL;
 	}
 
 
@@ -661,6 +1040,78 @@ namespace KaruahChess {
 	}
 
 
+	/// <summary>
+	/// Checks if neither side has enough material to checkmate. This is the case with a king and
+	/// at most one minor piece against a bare king, or when the only other pieces are bishops on the same colour squares.
+	/// </summary>
+	/// <returns></returns>
+	bool BitBoard::IsInsufficientMaterial()
+	{
+		if ((_positionWhitePawn | _positionWhiteRook | _positionWhiteQueen | _positionBlackPawn | _positionBlackRook | _positionBlackQueen) > 0) return false;
+
+		uint64_t minors = _positionWhiteKnight | _positionWhiteBishop | _positionBlackKnight | _positionBlackBishop;
+		if (helper::popcount(minors) <= 1) return true;
+
+		uint64_t bishops = _positionWhiteBishop | _positionBlackBishop;
+		return minors == bishops && ((bishops & helper::LIGHTSQUARES) == 0 || (bishops & ~helper::LIGHTSQUARES) == 0);
+	}
+
+
+	/// <summary>
+	/// Gets a key which identifies the position for repetition. The key combines the piece hash with the
+	/// side to move, castling availability and an en passant square which an enemy pawn could capture.
+	/// </summary>
+	/// <returns></returns>
+	uint64_t BitBoard::PositionKey()
+	{
+		uint64_t key = Hash;
+		if (StateActiveColour == helper::BLACKPIECE) key ^= helper::RandomStateArray[0];
+
+		for (int i = 0; i < 4; i++)
+		{
+			if ((StateCastlingAvailability >> i) & 1) key ^= helper::RandomStateArray[1 + i];
+		}
+
+		if (StateEnpassantIndex > -1)
+		{
+			uint64_t enpassantMask = helper::BITMASK >> StateEnpassantIndex;
+			uint64_t adjacent = ((enpassantMask << 1) & ~helper::FILEH) | ((enpassantMask >> 1) & ~helper::FILEA);
+			if ((adjacent & GetOccupiedBySpin(-_mailbox[StateEnpassantIndex])) > 0) key ^= helper::RandomStateArray[5 + StateEnpassantIndex % 8];
+		}
+
+		return key;
+	}
+
+
+	/// <summary>
+	/// Counts how many times the current position occurred before, since the last capture or pawn move
+	/// </summary>
+	/// <returns></returns>
+	int BitBoard::RepetitionCount()
+	{
+		int count = 0;
+		uint64_t key = PositionKey();
+		int historySize = (int)_moveHistory.size();
+		int oldest = std::max(0, historySize - StateHalfMoveCount);
+		for (int i = historySize - 2; i >= oldest; i -= 2)
+		{
+			if (_moveHistory[i].positionKey == key) count++;
+		}
+
+		return count;
+	}
+
+
+	/// <summary>
+	/// Gets the moves made since the board was set
+	/// </summary>
+	/// <returns></returns>
+	const std::vector<MoveHistoryItem>& BitBoard::GetMoveHistory()
+	{
+		return _moveHistory;
+	}
+
+
 	/// <summary>
 	/// Gets the index of the king
 	/// </summary>
@@ -796,6 +1247,7 @@ namespace KaruahChess {
 
 		// Invalidate move paths
 		_attackPathReady = false;
+		_attackPathRebuild = true;
 	}
 
 
@@ -819,6 +1271,7 @@ namespace KaruahChess {
 		pDestBoard._positionWhiteBishop = this->_positionWhiteBishop;
 		pDestBoard._positionWhiteQueen = this->_positionWhiteQueen;
 		pDestBoard._positionWhiteKing = this->_positionWhiteKing;
+		std::copy(this->_mailbox, _mailbox + 64, pDestBoard._mailbox);
 
 
 		// Copy hash
@@ -833,12 +1286,17 @@ namespace KaruahChess {
 		pDestBoard.StateFullMoveCount = this->StateFullMoveCount;
 		pDestBoard.StateWhiteClockOffset = this->StateWhiteClockOffset;
 		pDestBoard.StateBlackClockOffset = this->StateBlackClockOffset;
+		pDestBoard._moveHistory = this->_moveHistory;
 
 		// Copy attack paths
 		pDestBoard._attackPathReady = this->_attackPathReady;
+		pDestBoard._attackPathRebuild = this->_attackPathRebuild;
+		pDestBoard._attackPathDirty = this->_attackPathDirty;
+		pDestBoard._attackPathEnpassantIndex = this->_attackPathEnpassantIndex;
 
 		//  Source Start,  source end,  destination
 		std::copy(this->_attackPath, _attackPath + 64, pDestBoard._attackPath);
+		std::copy(this->_attackXRayPath, _attackXRayPath + 64, pDestBoard._attackXRayPath);
 
 		std::copy(this->_nonAttackPawnPath, _nonAttackPawnPath + 64, pDestBoard._nonAttackPawnPath);
 		std::copy(this->_castlePath, _castlePath + 64, pDestBoard._castlePath);
@@ -849,6 +1307,15 @@ namespace KaruahChess {
 		pDestBoard._blackAttack = this->_blackAttack;
 		pDestBoard._whitePotentialAttackPawn = this->_whitePotentialAttackPawn;
 		pDestBoard._blackPotentialAttackPawn = this->_blackPotentialAttackPawn;
+		pDestBoard._whiteAttackXRayBlackKing = this->_whiteAttackXRayBlackKing;
+		pDestBoard._blackAttackXRayWhiteKing = this->_blackAttackXRayWhiteKing;
+		pDestBoard._whitePos = this->_whitePos;
+		pDestBoard._blackPos = this->_blackPos;
+		pDestBoard._whiteCheckers = this->_whiteCheckers;
+		pDestBoard._blackCheckers = this->_blackCheckers;
+		pDestBoard._whitePinned = this->_whitePinned;
+		pDestBoard._blackPinned = this->_blackPinned;
+		pDestBoard._enpassantLegal = this->_enpassantLegal;
 	}
 
 
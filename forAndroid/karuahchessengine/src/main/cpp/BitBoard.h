@@ -24,6 +24,46 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 namespace KaruahChess {
 
+	// Information required to reverse a move made with MakeMove
+	struct MoveUndo {
+		int fromIndex = -1;
+		int toIndex = -1;
+		int fromSpin = 0;
+		int toSpin = 0;
+		int enpassantCaptureIndex = -1;
+		int enpassantCaptureSpin = 0;
+		int rookFromIndex = -1;
+		int rookToIndex = -1;
+		int rookSpin = 0;
+		int activeColour = 0;
+		int castlingAvailability = 0;
+		int enpassantIndex = -1;
+		int halfMoveCount = 0;
+		int fullMoveCount = 0;
+		uint64_t hash = 0ULL;
+		uint64_t hashPawn = 0ULL;
+	};
+
+	// The last move made, used to format the SAN of the move when requested
+	struct MoveSANInfo {
+		int fromIndex = -1;
+		int toIndex = -1;
+		int fromSpin = 0;
+		int promotionSpin = 0;
+		bool capture = false;
+		bool castle = false;
+		uint64_t ambiguous = 0ULL;
+	};
+
+	// A move made on the board with the state before the move. The move is packed as
+	// from index | to index << 6 | promotion piece << 12.
+	struct MoveHistoryItem {
+		uint64_t positionKey = 0ULL;
+		uint16_t move = 0;
+		int8_t castlingAvailability = 0;
+		int8_t enpassantIndex = -1;
+	};
+
 	// Class definition
 	class BitBoard {
 
@@ -45,9 +85,16 @@ namespace KaruahChess {
 
 		uint64_t* _positions[13];
 
+		// Spin of each square, kept in sync with the position bitboards
+		int8_t _mailbox[64];
+
 
 		bool _attackPathReady;
+		bool _attackPathRebuild;
+		uint64_t _attackPathDirty;
+		int _attackPathEnpassantIndex;
 		uint64_t _attackPath[64];
+		uint64_t _attackXRayPath[64];
 		uint64_t _nonAttackPawnPath[64];
 		uint64_t _potentialAttackPawnPath[64];
 		uint64_t _castlePath[64];
@@ -60,16 +107,26 @@ namespace KaruahChess {
 		uint64_t _blackPotentialAttackPawn;
 		uint64_t _whitePos;
 		uint64_t _blackPos;
+		uint64_t _whiteCheckers;
+		uint64_t _blackCheckers;
+		uint64_t _whitePinned;
+		uint64_t _blackPinned;
+		uint64_t _enpassantLegal;
 
 
 
 		void SetSpin(int pSqIndex, int pSpin);
 		void CalculateAttackPaths();
+		void CalculateSquareAttackPath(const int pSqIndex, const uint64_t pBlockers);
+		template<int Colour> void CalculateCheckPin(const int pKingIndex, const uint64_t pBlockers);
 		uint64_t ZobristSquareHash(int pSqIndex);
 
 
 		uint64_t _hashMaterial;
 
+		// Moves made since the board was set, used to detect repetition and to pass the game to the engine
+		std::vector<MoveHistoryItem> _moveHistory;
+
 	public:
 
 		uint64_t Hash;
@@ -78,7 +135,7 @@ namespace KaruahChess {
 
 		int MoveData[4];
 		std::string ReturnMessage;
-		std::string MoveSAN;
+		MoveSANInfo LastMoveSAN;
 
 		int StateActiveColour;
 		int StateGameStatus;
@@ -96,19 +153,27 @@ namespace KaruahChess {
 
 		// Functions
 		uint64_t GetPotentialMove(const int pSqIndex);
+		uint64_t GetPseudoLegalMove(const int pSqIndex);
 		void InvalidateAttackPath();
 		void Update(const int pSqIndex, const int pSpin);
+		void MakeMove(const int pFromIndex, const int pToIndex, const helper::PawnPromotionEnum pPawnPromotionPiece, MoveUndo& pUndo);
+		void UnmakeMove(const MoveUndo& pUndo);
 		void GetBoardArray(uint64_t pData[]);
 		std::string GetBoard();
 		std::string GetFullFEN();
 		std::string GetEnpassantFEN();
 		void SetBoardArray(const uint64_t pData[]);
 		void SetBoard(const std::string pFENstr);
+		void SetBoardSpin(const int8_t pSpin[]);
 		int GetSpin(const int pIndex);
 		uint64_t GetOccupiedBySpin(const int pSpin);
 		template<int Colour> uint64_t GetOccupiedBySpin(const int pSpin);
 		uint64_t GetOccupied(const int pColour);
 		bool OnlyKingsRemain();
+		bool IsInsufficientMaterial();
+		uint64_t PositionKey();
+		int RepetitionCount();
+		const std::vector<MoveHistoryItem>& GetMoveHistory();
 		template<int Colour> int KingIndex();
 		bool IsKingCheck(const int pColour);
 		std::string GetState();
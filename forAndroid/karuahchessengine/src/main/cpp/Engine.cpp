@@ -19,12 +19,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "engine.h"
 #include "helper.h"
+#include "bitboard.h"
+#include "search.h"
 #include "sf_uci.h"
 #include "sf_bitboard.h"
 #include "sf_position.h"
 #include "sf_search.h"
 #include "sf_thread.h"
 
+#include <algorithm>
 #include <thread>
 #include <filesystem>
 #include <istream>
@@ -35,34 +38,20 @@ namespace KaruahChess {
 		using namespace std;
 
 		bool SFInitialised = false;
-		bool NNUEInitialised = false;
-		unsigned int threadLimit = 0;
 
-		char* nnueFileBufferBig;
-		long nnueFileBufferSizeBig = 0;
-		string nnueFileNameBig;
-		bool nnueLoadedBig = false;
-
-		char* nnueFileBufferSmall;
-		long nnueFileBufferSizeSmall = 0;
-		string nnueFileNameSmall;
-		bool nnueLoadedSmall = false;
+		atomic<bool> nnueLoadedBig = false;
+		atomic<bool> nnueLoadedSmall = false;
 
 		EngineError engineErr;
 
-		std::unique_ptr<Stockfish::UCIEngine> mainUCI;
-
-
-		// Initialise the engine with NNUE
-		void init(string pNNUEFileNameBig, char* pNNUEFileBufferBig, long pNNUEFileBufferSizeBig, string pNNUEFileNameSmall, char* pNNUEFileBufferSmall, long pNNUEFileBufferSizeSmall) {
+		std::shared_ptr<const Stockfish::Eval::NNUE::SharedNetworks> sharedNetworks;
 
-			nnueFileNameBig = pNNUEFileNameBig;
-			nnueFileBufferBig = pNNUEFileBufferBig;
-			nnueFileBufferSizeBig = pNNUEFileBufferSizeBig;
 
-			nnueFileNameSmall = pNNUEFileNameSmall;
-			nnueFileBufferSmall = pNNUEFileBufferSmall;
-			nnueFileBufferSizeSmall = pNNUEFileBufferSizeSmall;
+		// Initialise the engine with NNUE. The networks are converted to weight blobs in the
+		// cache directory the first time, an empty directory disables the cache. The networks
+		// are loaded once and shared by the engine contexts. A context can be used as soon as
+		// this returns, the big network is loaded in the background.
+		void init(const NNUEFile& pNNUEFileBig, const NNUEFile& pNNUEFileSmall, const string& pNNUECacheDir) {
 
 			// Initialise Karuah Chess
 			helper::init();
@@ -72,18 +61,30 @@ namespace KaruahChess {
 
 				Stockfish::Bitboards::init();
 				Stockfish::Position::init();
-				mainUCI = std::make_unique<Stockfish::UCIEngine>();
-
-				setThreads(1);
 
 				SFInitialised = true;
 			}
 
+			if (!sharedNetworks) {
+				sharedNetworks = std::make_shared<const Stockfish::Eval::NNUE::SharedNetworks>(pNNUEFileBig, pNNUEFileSmall, pNNUECacheDir);
+			}
+
 		}
 
 
+		Context::Context() :
+			uciEngine(std::make_unique<Stockfish::UCIEngine>(sharedNetworks)),
+			state(std::make_unique<Search::SearchState>())
+		{
+			setThreads(1);
+		}
+
+
+		Context::~Context() = default;
+
+
 		// Initialise the threads, used to set the number of threads
-		void setThreads(unsigned int pRequestMaxThreads) {
+		void Context::setThreads(unsigned int pRequestMaxThreads) {
 
 			// Limit the maximum threads to at least one and always one less than the maximum
 			// so that some capacity is left over for the application
@@ -95,8 +96,131 @@ namespace KaruahChess {
 
 			if (threadLimit != newThreadLimit) {
 
-				Engine::mainUCI->engine_options()["Threads"] = std::to_string(newThreadLimit);
+				uciEngine->engine_options()["Threads"] = std::to_string(newThreadLimit);
+				threadLimit = newThreadLimit;
+			}
+		}
+
+
+		// Fills a Stockfish position setup from the spin of each square and the board state. The Stockfish
+		// board is a mirror of the Karuah Chess board by rank.
+		void fillPositionSetup(const int8_t pSpin[], const int pActiveColour, const int pCastlingAvailability, const int pEnpassantIndex, const int pHalfMoveCount, const int pFullMoveCount, Stockfish::PositionSetup& pSetup) {
+
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) {
+				int spin = pSpin[sqIndex];
+				Stockfish::Piece piece = spin > 0 ? Stockfish::Piece(spin) : spin < 0 ? Stockfish::Piece(8 - spin) : Stockfish::NO_PIECE;
+				pSetup.board[helper::mirrorRank(sqIndex)] = piece;
+			}
+
+			pSetup.sideToMove = pActiveColour == helper::BLACKPIECE ? Stockfish::BLACK : Stockfish::WHITE;
+
+			int castling = Stockfish::NO_CASTLING;
+			if (pCastlingAvailability & 0b000010) castling |= Stockfish::WHITE_OO;
+			if (pCastlingAvailability & 0b000001) castling |= Stockfish::WHITE_OOO;
+			if (pCastlingAvailability & 0b001000) castling |= Stockfish::BLACK_OO;
+			if (pCastlingAvailability & 0b000100) castling |= Stockfish::BLACK_OOO;
+			pSetup.castlingRights = Stockfish::CastlingRights(castling);
+
+			// The en passant index is the pawn that moved two squares, the target is the square behind it
+			pSetup.epSquare = Stockfish::SQ_NONE;
+			if (pEnpassantIndex >= 0 && pEnpassantIndex <= 63) {
+				int spin = pSpin[pEnpassantIndex];
+				if (spin == helper::WHITE_PAWN_SPIN) pSetup.epSquare = Stockfish::Square(helper::mirrorRank(pEnpassantIndex + 8));
+				else if (spin == helper::BLACK_PAWN_SPIN) pSetup.epSquare = Stockfish::Square(helper::mirrorRank(pEnpassantIndex - 8));
+			}
+
+			pSetup.rule50 = pHalfMoveCount;
+			pSetup.fullMove = pFullMoveCount;
+		}
+
+
+		// Fills a Stockfish position setup from the board
+		void toPositionSetup(BitBoard& pBoard, Stockfish::PositionSetup& pSetup) {
+
+			int8_t boardSpin[64];
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) boardSpin[sqIndex] = int8_t(pBoard.GetSpin(sqIndex));
+
+			fillPositionSetup(boardSpin, pBoard.StateActiveColour, pBoard.StateCastlingAvailability, pBoard.StateEnpassantIndex, pBoard.StateHalfMoveCount, pBoard.StateFullMoveCount, pSetup);
+		}
+
+
+		// Fills a Stockfish position setup and move list from the board history so that the engine
+		// can detect repetition. Only the moves since the last capture or pawn move can lead to a
+		// repetition, so the setup is the board with these moves taken back.
+		void toPositionSetup(BitBoard& pBoard, Stockfish::PositionSetup& pSetup, std::vector<Stockfish::Move>& pMoves) {
+
+			const std::vector<MoveHistoryItem>& history = pBoard.GetMoveHistory();
+			int historySize = (int)history.size();
+			int count = std::min(historySize, pBoard.StateHalfMoveCount);
+
+			int8_t boardSpin[64];
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) boardSpin[sqIndex] = int8_t(pBoard.GetSpin(sqIndex));
+
+			// Take back the moves, these can only be piece moves or castling. The moves are
+			// collected in reverse order for Stockfish, where castling is a king to rook move.
+			pMoves.clear();
+			int activeColour = pBoard.StateActiveColour;
+			int fullMoveCount = pBoard.StateFullMoveCount;
+			for (int i = historySize - 1; i >= historySize - count; i--) {
+				int fromIndex = history[i].move & 0x3F;
+				int toIndex = (history[i].move >> 6) & 0x3F;
+				int spin = boardSpin[toIndex];
+				Stockfish::Square from = Stockfish::Square(helper::mirrorRank(fromIndex));
+
+				boardSpin[fromIndex] = int8_t(spin);
+				boardSpin[toIndex] = 0;
+
+				int rookFromIndex = helper::CastleIndex[toIndex][0];
+				int rookToIndex = helper::CastleIndex[toIndex][1];
+				if ((spin == helper::WHITE_KING_SPIN || spin == helper::BLACK_KING_SPIN) && (fromIndex - toIndex == 2 || toIndex - fromIndex == 2) && rookFromIndex > -1) {
+					boardSpin[rookFromIndex] = boardSpin[rookToIndex];
+					boardSpin[rookToIndex] = 0;
+					pMoves.push_back(Stockfish::Move::make<Stockfish::CASTLING>(from, Stockfish::Square(helper::mirrorRank(rookFromIndex))));
+				}
+				else {
+					pMoves.push_back(Stockfish::Move(from, Stockfish::Square(helper::mirrorRank(toIndex))));
+				}
+
+				activeColour *= -1;
+				if (activeColour == helper::BLACKPIECE) fullMoveCount--;
 			}
+			std::reverse(pMoves.begin(), pMoves.end());
+
+			int castlingAvailability = count > 0 ? history[historySize - count].castlingAvailability : pBoard.StateCastlingAvailability;
+			int enpassantIndex = count > 0 ? history[historySize - count].enpassantIndex : pBoard.StateEnpassantIndex;
+			fillPositionSetup(boardSpin, activeColour, castlingAvailability, enpassantIndex, pBoard.StateHalfMoveCount - count, fullMoveCount, pSetup);
+		}
+
+
+		// Sets the board from a Stockfish position. The full move count is derived from the
+		// game ply in the same way as a FEN string written by the position.
+		void fromPosition(const Stockfish::Position& pPosition, BitBoard& pBoard) {
+
+			int8_t boardSpin[64];
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) {
+				Stockfish::Piece piece = pPosition.piece_on(Stockfish::Square(helper::mirrorRank(sqIndex)));
+				int pieceType = Stockfish::type_of(piece);
+				boardSpin[sqIndex] = int8_t(piece == Stockfish::NO_PIECE ? 0 : Stockfish::color_of(piece) == Stockfish::WHITE ? pieceType : -pieceType);
+			}
+			pBoard.SetBoardSpin(boardSpin);
+
+			pBoard.StateActiveColour = pPosition.side_to_move() == Stockfish::WHITE ? helper::WHITEPIECE : helper::BLACKPIECE;
+
+			// Keep the has castled flags, these are not part of the position
+			int castling = pBoard.StateCastlingAvailability & 0b110000;
+			if (pPosition.can_castle(Stockfish::WHITE_OO)) castling |= 0b000010;
+			if (pPosition.can_castle(Stockfish::WHITE_OOO)) castling |= 0b000001;
+			if (pPosition.can_castle(Stockfish::BLACK_OO)) castling |= 0b001000;
+			if (pPosition.can_castle(Stockfish::BLACK_OOO)) castling |= 0b000100;
+			pBoard.StateCastlingAvailability = castling;
+
+			// The en passant target is behind the pawn that moved two squares
+			Stockfish::Square epSquare = pPosition.ep_square();
+			if (epSquare == Stockfish::SQ_NONE) pBoard.StateEnpassantIndex = -1;
+			else pBoard.StateEnpassantIndex = helper::mirrorRank(epSquare) + (pPosition.side_to_move() == Stockfish::WHITE ? 8 : -8);
+
+			pBoard.StateHalfMoveCount = pPosition.rule50_count();
+			pBoard.StateFullMoveCount = 1 + (pPosition.game_ply() - (pPosition.side_to_move() == Stockfish::BLACK)) / 2;
 		}
 
 
@@ -18,36 +18,76 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <filesystem>
+#include <functional>
 #include <istream>
+#include <string>
 #include <streambuf>
 
 // Forward declaring class
 namespace Stockfish {
 	class UCIEngine;
+	class Position;
+	class Move;
+	struct PositionSetup;
+
+	namespace Eval::NNUE {
+		class SharedNetworks;
+	}
 }
 
 namespace KaruahChess {
+	class BitBoard;
+
+	namespace Search {
+		struct SearchState;
+	}
+
 	namespace Engine {
 
 		using namespace std;		
 
+		/// <summary>
+		/// Errors of the process. The errors are added by the engine contexts and the
+		/// network loader thread, so the list is locked.
+		/// </summary>
 		struct EngineError {
-			vector<int> errorList;
 
 			// Add the error to the list if it does not exist
 			void add(int errorNumber) {
+				lock_guard<mutex> lock(errorMutex);
 				if (find(errorList.begin(), errorList.end(), errorNumber) == errorList.end()) {
 					errorList.push_back(errorNumber);
 				}
 			}
 
 			// Checks for the existance of an error
-			bool exists(int errorNumber) {
+			bool exists(int errorNumber) const {
+				lock_guard<mutex> lock(errorMutex);
 				return find(errorList.begin(), errorList.end(), errorNumber) != errorList.end();
 			}
 
+			// Gets the first error, or 0 if there are no errors
+			int first() const {
+				lock_guard<mutex> lock(errorMutex);
+				return errorList.empty() ? 0 : errorList.front();
+			}
+
+			// Gets a copy of the errors
+			vector<int> list() const {
+				lock_guard<mutex> lock(errorMutex);
+				return errorList;
+			}
+
+		private:
+			vector<int> errorList;
+			mutable mutex errorMutex;
+
 		};
 
 		struct membuf : streambuf
@@ -57,21 +97,53 @@ namespace KaruahChess {
 			}
 		};
 
-		extern void init(string pNNUEFileNameBig, char* pNNUEFileBufferBig, long pNNUEFileBufferSizeBig, string pNNUEFileNameSmall, char* pNNUEFileBufferSmall, long pNNUEFileBufferSizeSmall);
-		extern void setThreads(unsigned int pMaxThreads);
-		extern EngineError engineErr;
+		/// <summary>
+		/// An NNUE file. The reader fills the buffer with the size bytes of the file. It is
+		/// only called when the network has not been converted to a weight blob in the
+		/// cache directory yet. The big network is loaded on a background thread, so the
+		/// reader may be called after the engine is initialised.
+		/// </summary>
+		struct NNUEFile {
+			string name;
+			long size = 0;
+			function<bool(char* pBuffer, long pSize)> read;
+		};
+
+		/// <summary>
+		/// An engine instance with its own search threads, transposition table, options and
+		/// search result cache. All the contexts share the networks loaded by init, so a second
+		/// game or an engine against engine match does not load another set of weights.
+		/// init must be called before a context is created.
+		/// </summary>
+		class Context {
+		public:
+			Context();
+			~Context();
+
+			Context(const Context&) = delete;
+			Context& operator=(const Context&) = delete;
+
+			void setThreads(unsigned int pMaxThreads);
+
+			Stockfish::UCIEngine& uci() { return *uciEngine; }
+			Search::SearchState& searchState() { return *state; }
+
+		private:
+			std::unique_ptr<Stockfish::UCIEngine> uciEngine;
+			std::unique_ptr<Search::SearchState> state;
+			unsigned int threadLimit = 0;
+		};
 
-		extern string nnueFileNameBig;
-		extern char* nnueFileBufferBig;
-		extern long nnueFileBufferSizeBig;
-		extern bool nnueLoadedBig;
+		extern void init(const NNUEFile& pNNUEFileBig, const NNUEFile& pNNUEFileSmall, const string& pNNUECacheDir);
+		extern void toPositionSetup(BitBoard& pBoard, Stockfish::PositionSetup& pSetup);
+		extern void toPositionSetup(BitBoard& pBoard, Stockfish::PositionSetup& pSetup, std::vector<Stockfish::Move>& pMoves);
+		extern void fromPosition(const Stockfish::Position& pPosition, BitBoard& pBoard);
+		extern EngineError engineErr;
 
-		extern string nnueFileNameSmall;
-		extern char* nnueFileBufferSmall;
-		extern long nnueFileBufferSizeSmall;
-		extern bool nnueLoadedSmall;
+		extern atomic<bool> nnueLoadedBig;
+		extern atomic<bool> nnueLoadedSmall;
 
-		extern std::unique_ptr<Stockfish::UCIEngine> mainUCI;
+		extern std::shared_ptr<const Stockfish::Eval::NNUE::SharedNetworks> sharedNetworks;
 	}
 
 }
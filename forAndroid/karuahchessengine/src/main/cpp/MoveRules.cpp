@@ -19,6 +19,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "moverules.h"
 #include "helper.h"
 #include "bitboard.h"
+#include "piecepattern.h"
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 namespace KaruahChess {
@@ -30,8 +33,6 @@ namespace KaruahChess {
 		/// </summary>
 		bool Move(const int pFromIndex, const int pToIndex, BitBoard& pBoard, const helper::PawnPromotionEnum pPawnPromotionPiece, const bool pValidateEnabled, const bool pCommit)
 		{
-			bool success = true;
-
 			// Get original values before move
 			int origFromSpin = pBoard.GetSpin(pFromIndex);
 			int origToSpin = pBoard.GetSpin(pToIndex);
@@ -60,211 +61,51 @@ namespace KaruahChess {
 				}
 
 				// Validate to move
-				uint64_t attackPath = pBoard.GetPotentialMove(pFromIndex);
+				uint64_t attackPath = pBoard.GetPseudoLegalMove(pFromIndex);
 				if (((helper::BITMASK >> pToIndex) & attackPath) == 0)
 				{
 					pBoard.ReturnMessage = "Move from " + helper::BoardCoordinateDict.at(pFromIndex) + " to " + helper::BoardCoordinateDict.at(pToIndex) + " is not valid";
 					return false;
 				}
 
-			}
-
-			
-			// Disambiguation for PGN			
-			auto toSq = helper::BoardCoordinateDict.at(pToIndex);     // e.g. "e4"
-			auto fromSq = helper::BoardCoordinateDict.at(pFromIndex); // e.g. "e2"
-			std::string disamb;						
-			std::vector<int> none;
-			int findRes = FindFromIndex(pBoard, pToIndex, origFromSpin, none, false);
-
-			if (findRes == -2)
-			{
-				// Ambiguous: try file, then rank, else full square
-				int fromFile = pFromIndex % 8;
-				int fromRank = pFromIndex / 8;
-
-				std::vector<int> byFile;
-				std::vector<int> byRank;
-				byFile.reserve(8);
-				byRank.reserve(8);
-
-				// Build candidate lists by file and by rank for this piece type
-				for (int i = 0; i < 64; ++i)
-				{
-					if (pBoard.GetSpin(i) == origFromSpin)
-					{
-						if ((i % 8) == fromFile) byFile.push_back(i);
-						if ((i / 8) == fromRank) byRank.push_back(i);
-					}
-				}
-
-				int fileRes = FindFromIndex(pBoard, pToIndex, origFromSpin, byFile, false);
-				if (fileRes == pFromIndex)
+				// Reject the move if the king is in check after move
+				if (((helper::BITMASK >> pToIndex) & pBoard.GetPotentialMove(pFromIndex)) == 0)
 				{
-					// File uniquely identifies
-					disamb.push_back(fromSq[0]);
-				}
-				else
-				{
-					int rankRes = FindFromIndex(pBoard, pToIndex, origFromSpin, byRank, false);
-					if (rankRes == pFromIndex)
-					{
-						// Rank uniquely identifies
-						disamb.push_back(fromSq[1]);
-					}
-					else
-					{
-						// Need full square
-						disamb += fromSq;
-					}
+					pBoard.ReturnMessage = "Cannot make this move. King would be in check.";
+					return false;
 				}
-			}
-			
-
-
-			// Do the move
-			pBoard.Update(pFromIndex, 0);
-			pBoard.Update(pToIndex, origFromSpin);
-
-
-			// Check for pawn promotion
-			bool didPromotion = false;
-			if (origFromSpin == helper::WHITE_PAWN_SPIN && pToIndex >= 0 && pToIndex <= 7)
-			{
-				int pawnPromotion = (int)pPawnPromotionPiece * pBoard.StateActiveColour;
-				pBoard.Update(pToIndex, pawnPromotion);
-				didPromotion = true;
-			}
-			else if (origFromSpin == helper::BLACK_PAWN_SPIN && pToIndex >= 56 && pToIndex <= 63)
-			{
-				int pawnPromotion = (int)pPawnPromotionPiece * pBoard.StateActiveColour;
-				pBoard.Update(pToIndex, pawnPromotion);
-				didPromotion = true;
-			}
-
-			// Variables
-			bool enPassant = false;
-			bool castle = false;
-			int rookFromSqIndex = -1;
-			int rookToSqIndex = -1;
-			int rookSpin = 0;
-
-			// Store original values
-			int origEnpassantIndex = pBoard.StateEnpassantIndex;
-			int origEnpassantSpin = pBoard.GetSpin(pBoard.StateEnpassantIndex);
 
-			// Detect enpassant
-			if ((origFromSpin == helper::WHITE_PAWN_SPIN && (pToIndex + 8) == pBoard.StateEnpassantIndex) || (origFromSpin == helper::BLACK_PAWN_SPIN && (pToIndex - 8) == pBoard.StateEnpassantIndex))
-			{
-				// Do Enpassant take
-				pBoard.Update(pBoard.StateEnpassantIndex, 0);
-				enPassant = true;
 			}
 
 
-			// Castle the rook
-			if ((origFromSpin == helper::WHITE_KING_SPIN && pFromIndex == 60) || (origFromSpin == helper::BLACK_KING_SPIN && pFromIndex == 4))
+			// Other pieces of the same type which can also legally move to the square, for SAN disambiguation
+			uint64_t ambiguous = 0ULL;
+			if (pCommit && origFromSpin != helper::WHITE_PAWN_SPIN && origFromSpin != helper::BLACK_PAWN_SPIN)
 			{
-				rookFromSqIndex = helper::CastleIndex[pToIndex][0];
-				rookToSqIndex = helper::CastleIndex[pToIndex][1];
-
-				if (rookFromSqIndex > -1 && rookToSqIndex > -1)
+				uint64_t otherScan = pBoard.GetOccupiedBySpin(origFromSpin) & ~(helper::BITMASK >> pFromIndex);
+				while (otherScan > 0)
 				{
-					// Move rook
-					rookSpin = pBoard.GetSpin(rookFromSqIndex);
-					pBoard.Update(rookToSqIndex, rookSpin);
-					pBoard.Update(rookFromSqIndex, 0);
-					castle = true;
+					int posScan = helper::BitScanForward(otherScan);
+					otherScan ^= 1uLL << posScan;
+					if (((helper::BITMASK >> pToIndex) & pBoard.GetPotentialMove(63 - posScan)) > 0) ambiguous |= 1uLL << posScan;
 				}
-
 			}
 
-			// Reject the move if the king is in check after move
-			if (pValidateEnabled && pBoard.IsKingCheck(pBoard.StateActiveColour))
+			// Do the move
+			MoveUndo undo;
+			pBoard.MakeMove(pFromIndex, pToIndex, pPawnPromotionPiece, undo);
+			bool didPromotion = (origFromSpin == helper::WHITE_PAWN_SPIN && pToIndex >= 0 && pToIndex <= 7) || (origFromSpin == helper::BLACK_PAWN_SPIN && pToIndex >= 56 && pToIndex <= 63);
+			bool enPassant = undo.enpassantCaptureIndex > -1;
+			bool castle = undo.rookFromIndex > -1;
+
+			// Reverse moves, restore board to original state if commit is false
+			if (!pCommit)
 			{
-				pBoard.ReturnMessage = "Cannot make this move. King would be in check.";
-				success = false;
-			}
-
-
-			// Reverse moves, restore board to original state if error, or commit is false
-			if (!success || !pCommit)
-			{
-				// Reverse the move
-				pBoard.Update(pToIndex, origToSpin);
-				pBoard.Update(pFromIndex, origFromSpin);
-
-				// Reverse enpassant
-				if (enPassant)
-				{
-					pBoard.Update(origEnpassantIndex, origEnpassantSpin);
-					pBoard.StateEnpassantIndex = origEnpassantIndex;
-				}
-
-				// Reverse castle
-				if (castle)
-				{
-					pBoard.Update(rookToSqIndex, 0);
-					pBoard.Update(rookFromSqIndex, rookSpin);
-				}
-
-
+				pBoard.UnmakeMove(undo);
 			}
 			else
 			{
 
-				// Update EnPassant potential
-				int distance = pFromIndex - pToIndex;
-				if ((distance == 16 || distance == -16) && (origFromSpin == helper::WHITE_PAWN_SPIN || origFromSpin == helper::BLACK_PAWN_SPIN))
-				{
-					pBoard.InvalidateAttackPath();
-					pBoard.StateEnpassantIndex = pToIndex;
-				}
-				else
-				{
-					pBoard.StateEnpassantIndex = -1;
-				}
-
-				// Increment the full move count after blacks move
-				if (pBoard.StateActiveColour == helper::BLACKPIECE)
-				{
-					pBoard.StateFullMoveCount += 1;
-				}
-
-				// Increment half move count if no piece was captured or a pawn was not advanced. Used for fifty move rule.
-				if (origToSpin != 0 || origFromSpin == helper::WHITE_PAWN_SPIN || origFromSpin == helper::BLACK_PAWN_SPIN)
-				{
-					pBoard.StateHalfMoveCount = 0;
-				}
-				else
-				{
-					pBoard.StateHalfMoveCount += 1;
-				}
-
-				// Change the turn, as this turn is now complete
-				pBoard.StateActiveColour *= -1;
-
-
-				// Update castling availability
-				if (origFromSpin == helper::WHITE_ROOK_SPIN && pFromIndex == 63) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111101;
-				else if (origFromSpin == helper::WHITE_ROOK_SPIN && pFromIndex == 56) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111110;
-				else if (origFromSpin == helper::BLACK_ROOK_SPIN && pFromIndex == 7) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b110111;
-				else if (origFromSpin == helper::BLACK_ROOK_SPIN && pFromIndex == 0) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111011;
-				else if (origFromSpin == helper::WHITE_KING_SPIN) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111100;
-				else if (origFromSpin == helper::BLACK_KING_SPIN) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b110011;
-
-				if (pToIndex == 63) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111101;
-				else if (pToIndex == 56) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111110;
-				else if (pToIndex == 7) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b110111;
-				else if (pToIndex == 0) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability & 0b111011;
-
-
-				// Update has castled flag
-				if (castle && origFromSpin == helper::BLACK_KING_SPIN) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability | 0b100000;
-				else if (castle && origFromSpin == helper::WHITE_KING_SPIN) pBoard.StateCastlingAvailability = pBoard.StateCastlingAvailability | 0b010000;
-
-
-
 				// Update game status
 				if (pValidateEnabled)
 				{
@@ -278,13 +119,16 @@ namespace KaruahChess {
 						pBoard.ReturnMessage = "En passant";
 					}
 
-					if (IsCheckMate(pBoard))
+					// Checkmate and stalemate end the game. A board with only kings is also recorded as a stalemate.
+					// Other draws are reported by GetGameStatus and left for the caller to act on.
+					helper::GameStatusEnum gameStatus = GetGameStatus(pBoard);
+					if (gameStatus == helper::GameStatusEnum::Checkmate)
 					{
-						pBoard.StateGameStatus = 1;
+						pBoard.StateGameStatus = (int)helper::BoardStatusEnum::Checkmate;
 					}
-					else if (IsStaleMate(pBoard))
+					else if (gameStatus == helper::GameStatusEnum::Stalemate || (gameStatus == helper::GameStatusEnum::InsufficientMaterial && pBoard.OnlyKingsRemain()))
 					{
-						pBoard.StateGameStatus = 2;
+						pBoard.StateGameStatus = (int)helper::BoardStatusEnum::Stalemate;
 					}
 				}
 
@@ -295,238 +139,251 @@ namespace KaruahChess {
 				pBoard.MoveData[3] = origToSpin;
 								
 
-				// Determine piece letter (empty for pawns)
-				char pieceChar = '\0';
-				int absSpin = origFromSpin < 0 ? -origFromSpin : origFromSpin;
-				if (absSpin == helper::WHITE_KING_SPIN) pieceChar = 'K';
-				else if (absSpin == helper::WHITE_QUEEN_SPIN) pieceChar = 'Q';
-				else if (absSpin == helper::WHITE_ROOK_SPIN) pieceChar = 'R';
-				else if (absSpin == helper::WHITE_BISHOP_SPIN) pieceChar = 'B';
-				else if (absSpin == helper::WHITE_KNIGHT_SPIN) pieceChar = 'N';
-				// Pawns => pieceChar stays '\0'
-
-				bool isCapture = (origToSpin != 0) || enPassant;
-
-				// Promotion?				
-				char promoChar = '\0';				
-				if (didPromotion)
-				{
-					switch (pPawnPromotionPiece)
-					{
-					case helper::PawnPromotionEnum::Queen:  promoChar = 'Q'; break;
-					case helper::PawnPromotionEnum::Rook:   promoChar = 'R'; break;
-					case helper::PawnPromotionEnum::Bishop: promoChar = 'B'; break;
-					case helper::PawnPromotionEnum::Knight: promoChar = 'N'; break;
-					default: promoChar = 'Q'; break;
-					}
-				}
+				// Store the move so the SAN can be formatted when requested
+				pBoard.LastMoveSAN.fromIndex = pFromIndex;
+				pBoard.LastMoveSAN.toIndex = pToIndex;
+				pBoard.LastMoveSAN.fromSpin = origFromSpin;
+				pBoard.LastMoveSAN.promotionSpin = didPromotion ? pBoard.GetSpin(pToIndex) : 0;
+				pBoard.LastMoveSAN.capture = (origToSpin != 0) || enPassant;
+				pBoard.LastMoveSAN.castle = castle;
+				pBoard.LastMoveSAN.ambiguous = ambiguous;
+			}
+
 
-				std::string san;
+			return true;
+		}
+
+
+		/// <summary>
+		/// Formats the SAN of the last move made on the board in to pSAN, which must hold MAX_SAN_LENGTH characters.
+		/// </summary>
+		/// <returns>Length of the SAN, 0 if there is no move</returns>
+		int GetMoveSAN(BitBoard& pBoard, char pSAN[])
+		{
+			const MoveSANInfo& move = pBoard.LastMoveSAN;
+			int length = 0;
+
+			if (move.fromIndex < 0 || move.toIndex < 0)
+			{
+				pSAN[0] = '\0';
+				return 0;
+			}
+
+			char fromFile = char('a' + move.fromIndex % 8);
+			char fromRank = char('8' - move.fromIndex / 8);
+			int absSpin = move.fromSpin < 0 ? -move.fromSpin : move.fromSpin;
+
+			if (move.castle)
+			{
+				pSAN[length++] = 'O';
+				pSAN[length++] = '-';
+				pSAN[length++] = 'O';
 
-				if (castle)
+				// Queen side if the king moved towards the a file
+				if (move.toIndex % 8 < move.fromIndex % 8)
 				{
-					// Determine side by files
-					int fromFile = pFromIndex % 8;
-					int toFile = pToIndex % 8;
-					san = (toFile > fromFile) ? "O-O" : "O-O-O";
+					pSAN[length++] = '-';
+					pSAN[length++] = 'O';
+				}
+			}
+			else
+			{
+				if (absSpin == helper::PAWN_SPIN)
+				{
+					// File letter of the from square for pawn captures
+					if (move.capture) pSAN[length++] = fromFile;
 				}
 				else
 				{
-					if (pieceChar == '\0')
+					pSAN[length++] = helper::FENCharBySpin[absSpin + 6];
+
+					// Disambiguate by file, then rank, else full square
+					if (move.ambiguous > 0)
 					{
-						// Pawn moves
-						if (isCapture)
-						{
-							// File letter of the from square + 'x' + to							
-							san.push_back(fromSq[0]);
-							san.push_back('x');
-							san += toSq;
-						}
+						uint64_t fileMask = helper::FILEA >> (move.fromIndex % 8);
+						uint64_t rankMask = helper::RowMask[move.fromIndex];
+						if ((move.ambiguous & fileMask) == 0) pSAN[length++] = fromFile;
+						else if ((move.ambiguous & rankMask) == 0) pSAN[length++] = fromRank;
 						else
 						{
-							// Just destination square
-							san = toSq;
-						}
-
-						if (didPromotion)
-						{
-							san.push_back('=');
-							san.push_back(promoChar);
+							pSAN[length++] = fromFile;
+							pSAN[length++] = fromRank;
 						}
 					}
-					else
-					{
-						// Pieces: letter + optional 'x' + destination (no disambiguation here)
-						san.push_back(pieceChar);
-												
-						// Append disambiguation if any
-						if (!disamb.empty()) san += disamb;
-
-						if (isCapture) san.push_back('x');
+				}
 
-						san += toSq;
-					}
+				if (move.capture) pSAN[length++] = 'x';
 
-				}
+				pSAN[length++] = char('a' + move.toIndex % 8);
+				pSAN[length++] = char('8' - move.toIndex / 8);
 
-				// Check/mate suffix
-				if (pBoard.StateGameStatus == 1)
-				{
-					// Checkmate as determined above
-					san.push_back('#');
-				}
-				else if (pBoard.IsKingCheck(pBoard.StateActiveColour))
+				if (move.promotionSpin != 0)
 				{
-					// Opponent is in check after this move
-					san.push_back('+');
+					pSAN[length++] = '=';
+					pSAN[length++] = helper::FENCharBySpin[(move.promotionSpin < 0 ? -move.promotionSpin : move.promotionSpin) + 6];
 				}
-
-				pBoard.MoveSAN = san;
-
-
 			}
 
+			// Check/mate suffix
+			if (pBoard.StateGameStatus == (int)helper::BoardStatusEnum::Checkmate) pSAN[length++] = '#';
+			else if (pBoard.IsKingCheck(pBoard.StateActiveColour)) pSAN[length++] = '+';
 
-			return success;
+			pSAN[length] = '\0';
+			return length;
 		}
 
 
 		/// <summary>
-		/// Determines if colour is in check mate or stalemate
+		/// Determines if colour is in check mate
 		/// </summary>
 		bool IsCheckMate(BitBoard& pBoard)
 		{
-			bool moveFound = false;
-			int posScanFrom;
-			int posScanTo;
-			uint64_t potentialScanTo;
-			int fromIndex;
-			int toIndex;
-
-			bool isKingCheck = pBoard.IsKingCheck(pBoard.StateActiveColour);
-			if (!isKingCheck) return false;
-
-			uint64_t originalBoardArray[276];
-			pBoard.GetBoardArray(originalBoardArray);
-
-			int originalStateArray[8];
-			pBoard.GetStateArray(originalStateArray);
-
-			uint64_t occupiedScanFrom = pBoard.GetOccupied(pBoard.StateActiveColour);
-			while (occupiedScanFrom > 0)
-			{
-				posScanFrom = helper::BitScanForward(occupiedScanFrom);
-				occupiedScanFrom ^= 1uLL << posScanFrom;
-				fromIndex = (63 - posScanFrom);
-
-				potentialScanTo = pBoard.GetPotentialMove(fromIndex);
-				while (potentialScanTo > 0)
-				{
-					posScanTo = helper::BitScanForward(potentialScanTo);
-					potentialScanTo ^= 1uLL << posScanTo;
-					toIndex = (63 - posScanTo);
-
-					bool success = Move(fromIndex, toIndex, pBoard, helper::PawnPromotionEnum::Queen, false, true);
-					if (success)
-					{
-						int previousTurn = -pBoard.StateActiveColour;
-						// reject the move if the king is still in check
-						if (!pBoard.IsKingCheck(previousTurn))
-						{
-							moveFound = true;
-							// Restore original board
-							pBoard.SetBoardArray(originalBoardArray);
-							pBoard.SetStateArray(originalStateArray);
-
-							break;
-						}
+			return GetGameStatus(pBoard) == helper::GameStatusEnum::Checkmate;
+		}
 
-						// Restore original board
-						pBoard.SetBoardArray(originalBoardArray);
-						pBoard.SetStateArray(originalStateArray);
-					}
 
-				}
+		/// <summary>
+		/// Determines if board is in stalemate, helper method
+		/// </summary>
+		bool IsStaleMate(BitBoard& pBoard)
+		{
+			// Stale mate exists if only kings are left on the board
+			if (pBoard.OnlyKingsRemain()) return true;
 
-				if (moveFound) break;
+			return GetGameStatus(pBoard) == helper::GameStatusEnum::Stalemate;
+		}
 
 
+		/// <summary>
+		/// Determines if the side to move has at least one legal move. Stops at the first piece found with a legal move.
+		/// </summary>
+		bool HasLegalMove(BitBoard& pBoard)
+		{
+			uint64_t occupiedScan = pBoard.GetOccupied(pBoard.StateActiveColour);
+			while (occupiedScan > 0)
+			{
+				int posScan = helper::BitScanForward(occupiedScan);
+				occupiedScan ^= 1uLL << posScan;
+				if (pBoard.GetPotentialMove(63 - posScan) > 0) return true;
 			}
 
-
-			return !moveFound && isKingCheck;
-
+			return false;
 		}
 
+
 		/// <summary>
-		/// Determines if board is in stalemate, helper method
+		/// Gets the status of the game for the side to move. Checkmate and stalemate are found with one
+		/// legal move pass which stops at the first legal move, then the draw rules are checked.
 		/// </summary>
-		bool IsStaleMate(BitBoard& pBoard)
+		helper::GameStatusEnum GetGameStatus(BitBoard& pBoard)
 		{
-			// Stale mate exists if only kings are left on the board
-			bool onlyKingsRemaining = pBoard.OnlyKingsRemain();
-			if (onlyKingsRemaining) return true;
+			if (!HasLegalMove(pBoard))
+			{
+				return pBoard.IsKingCheck(pBoard.StateActiveColour) ? helper::GameStatusEnum::Checkmate : helper::GameStatusEnum::Stalemate;
+			}
 
-			bool isKingCheck = pBoard.IsKingCheck(pBoard.StateActiveColour);
+			if (pBoard.IsInsufficientMaterial()) return helper::GameStatusEnum::InsufficientMaterial;
+			if (pBoard.StateHalfMoveCount >= 100) return helper::GameStatusEnum::FiftyMove;
+			if (pBoard.RepetitionCount() >= 2) return helper::GameStatusEnum::Repetition;
 
-			// Check if valid move found
-			bool moveFound = false;
-			int posScanFrom;
-			int posScanTo;
-			uint64_t potentialScanTo;
-			int fromIndex;
-			int toIndex;
+			return helper::GameStatusEnum::None;
+		}
 
-			uint64_t originalBoardArray[276];
-			pBoard.GetBoardArray(originalBoardArray);
 
-			int originalStateArray[8];
-			pBoard.GetStateArray(originalStateArray);
+		/// <summary>
+		/// Adds the legal moves of the side to move to the move list
+		/// </summary>
+		template<int Colour> void AddLegalMoves(BitBoard& pBoard, MoveList& pMoveList)
+		{
+			uint64_t pawns = pBoard.GetOccupiedBySpin<Colour>(helper::PAWN_SPIN);
+			uint64_t promotionRank = Colour == helper::WHITEPIECE ? helper::RANK8 : helper::RANK1;
 
-			uint64_t occupiedScanFrom = pBoard.GetOccupied(pBoard.StateActiveColour);
+			uint64_t occupiedScanFrom = pBoard.GetOccupied(Colour);
 			while (occupiedScanFrom > 0)
 			{
-				posScanFrom = helper::BitScanForward(occupiedScanFrom);
+				int posScanFrom = helper::BitScanForward(occupiedScanFrom);
 				occupiedScanFrom ^= 1uLL << posScanFrom;
-				fromIndex = (63 - posScanFrom);
+				int fromIndex = 63 - posScanFrom;
+
+				uint64_t legal = pBoard.GetPotentialMove(fromIndex);
+				bool isPawn = ((helper::BITMASK >> fromIndex) & pawns) > 0;
+
+				pMoveList.legalTo[fromIndex] = legal;
 
-				potentialScanTo = pBoard.GetPotentialMove(fromIndex);
-				while (potentialScanTo > 0)
+				while (legal > 0)
 				{
-					posScanTo = helper::BitScanForward(potentialScanTo);
-					potentialScanTo ^= 1uLL << posScanTo;
-					toIndex = (63 - posScanTo);
+					int posScanTo = helper::BitScanForward(legal);
+					legal ^= 1uLL << posScanTo;
+					int toIndex = 63 - posScanTo;
 
-					bool success = Move(fromIndex, toIndex, pBoard, helper::PawnPromotionEnum::Queen, false, true);
-					if (success)
+					if (isPawn && ((helper::BITMASK >> toIndex) & promotionRank) > 0)
 					{
-						// Reject the move if the king is still in check
-						if (!pBoard.IsKingCheck(-pBoard.StateActiveColour))
+						for (int promotion = (int)helper::PawnPromotionEnum::Queen; promotion >= (int)helper::PawnPromotionEnum::Knight; promotion--)
 						{
-							moveFound = true;
-							// Restore original board
-							pBoard.SetBoardArray(originalBoardArray);
-							pBoard.SetStateArray(originalStateArray);
-							break;
+							pMoveList.moves[pMoveList.count++] = { fromIndex, toIndex, promotion };
 						}
-
-						// Restore original board
-						pBoard.SetBoardArray(originalBoardArray);
-						pBoard.SetStateArray(originalStateArray);
+					}
+					else
+					{
+						pMoveList.moves[pMoveList.count++] = { fromIndex, toIndex, 0 };
 					}
 				}
+			}
+		}
 
-				if (moveFound) break;
 
-			}
+		/// <summary>
+		/// Generates all legal moves of the side to move
+		/// </summary>
+		void GenerateLegalMoves(BitBoard& pBoard, MoveList& pMoveList)
+		{
+			pMoveList.count = 0;
+			std::fill(std::begin(pMoveList.legalTo), std::end(pMoveList.legalTo), 0uLL);
+
+			if (pBoard.StateActiveColour == helper::WHITEPIECE) AddLegalMoves<helper::WHITEPIECE>(pBoard, pMoveList);
+			else AddLegalMoves<helper::BLACKPIECE>(pBoard, pMoveList);
+		}
 
-			bool cannotMoveNotInCheck = (moveFound == false && !isKingCheck);
-			bool stalemate = onlyKingsRemaining || (!onlyKingsRemaining && cannotMoveNotInCheck);
 
-			return stalemate;
+		/// <summary>
+		/// Gets the legal destinations of the piece on a square. Only the moves from that square are
+		/// generated, so querying every square does not regenerate the whole move list each time.
+		/// </summary>
+		uint64_t GetLegalMove(BitBoard& pBoard, const int pSqIndex)
+		{
+			if (pSqIndex < 0 || pSqIndex > 63) return 0;
+			if ((pBoard.GetOccupied(pBoard.StateActiveColour) & (helper::BITMASK >> pSqIndex)) == 0) return 0;
 
+			return pBoard.GetPotentialMove(pSqIndex);
 		}
 
+
+		/// <summary>
+		/// Makes the legal move which leads to the next board, so the move is added to the board history.
+		/// Used to rebuild the history from stored boards for repetition detection.
+		/// </summary>
+		/// <returns>False if no legal move leads to the next board, the board is unchanged</returns>
+		bool ReplayMove(BitBoard& pBoard, BitBoard& pNextBoard)
+		{
+			uint64_t nextKey = pNextBoard.PositionKey();
+
+			MoveList moveList;
+			GenerateLegalMoves(pBoard, moveList);
+			for (int i = 0; i < moveList.count; i++)
+			{
+				const MoveListItem& move = moveList.moves[i];
+				helper::PawnPromotionEnum promotion = move.promotionPieceType > 0 ? (helper::PawnPromotionEnum)move.promotionPieceType : helper::PawnPromotionEnum::Queen;
+
+				MoveUndo undo;
+				pBoard.MakeMove(move.fromIndex, move.toIndex, promotion, undo);
+				if (pBoard.PositionKey() == nextKey) return true;
+				pBoard.UnmakeMove(undo);
+			}
+
+			return false;
+		}
+
+
 		/// <summary>
 		/// Used for arranging pieces on the board.
 		/// </summary>
@@ -631,7 +488,7 @@ namespace KaruahChess {
 			// Kings cannot be removed or changed to another piece so not updating castling availability for king changes here
 
 			// Clear the PGN san as it is likely not valid after an arrange update
-			pBoard.MoveSAN = "";
+			pBoard.LastMoveSAN = MoveSANInfo();
 
 			return status;
 		}
@@ -645,30 +502,18 @@ namespace KaruahChess {
 			uint64_t occupied = pBoard.GetOccupiedBySpin(pSpin);
 			std::vector<int> possibleList;
 
+			// Only legal moves are considered when testing the move
+			MoveList moveList;
+			if (pTestMove) GenerateLegalMoves(pBoard, moveList);
 
 			for (int fromIndex = 0; fromIndex < 64; fromIndex++)
 			{
 				if (((helper::BITMASK >> fromIndex) & occupied) > 0)
 				{
-					uint64_t potSq = pBoard.GetPotentialMove(fromIndex);
-					for (int j = 0; j < 64; j++)
+					uint64_t potSq = pTestMove ? moveList.legalTo[fromIndex] : pBoard.GetPseudoLegalMove(fromIndex);
+					if (((helper::BITMASK >> pToIndex) & potSq) > 0)
 					{
-						if (((helper::BITMASK >> j) & potSq) > 0 && j == pToIndex)
-						{	
-							if (pTestMove) {
-								// Test the move before adding
-								if (Move(fromIndex, pToIndex, pBoard, helper::PawnPromotionEnum::Queen, true, false))
-								{
-									possibleList.push_back(fromIndex);
-									break;
-								}
-							}
-							else {
-								// Don't test the move before adding
-								possibleList.push_back(fromIndex);
-								break;
-							}
-						}
+						possibleList.push_back(fromIndex);
 					}
 				}
 			}
@@ -718,8 +563,8 @@ namespace KaruahChess {
 			if ((origFromSpin == helper::WHITE_PAWN_SPIN && pToIndex >= 0 && pToIndex <= 7) ||
 				(origFromSpin == helper::BLACK_PAWN_SPIN && pToIndex >= 56 && pToIndex <= 63))
 			{
-				// test the move but don't commit it
-				return Move(pFromIndex, pToIndex, pBoard, helper::PawnPromotionEnum::Queen, true, false);
+				// Check the move is legal
+				return ((helper::BITMASK >> pToIndex) & GetLegalMove(pBoard, pFromIndex)) > 0;
 			}
 
 			return false;
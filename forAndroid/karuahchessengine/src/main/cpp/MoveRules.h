@@ -19,11 +19,36 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 #include "helper.h"
 #include "bitboard.h"
+#include <cstdint>
+#include <vector>
 
 namespace KaruahChess {
 	namespace MoveRules {
+
+		constexpr int MAX_MOVES = 256;
+		constexpr int MAX_SAN_LENGTH = 10;
+
+		struct MoveListItem {
+			int fromIndex = -1;
+			int toIndex = -1;
+			int promotionPieceType = 0;
+		};
+
+		// Legal moves of the side to move. legalTo holds the legal destinations of each from square.
+		struct MoveList {
+			MoveListItem moves[MAX_MOVES];
+			int count = 0;
+			uint64_t legalTo[64];
+		};
+
 		extern bool IsCheckMate(BitBoard& pBoard);
 		extern bool IsStaleMate(BitBoard& pBoard);
+		extern bool HasLegalMove(BitBoard& pBoard);
+		extern helper::GameStatusEnum GetGameStatus(BitBoard& pBoard);
+		extern void GenerateLegalMoves(BitBoard& pBoard, MoveList& pMoveList);
+		extern uint64_t GetLegalMove(BitBoard& pBoard, const int pSqIndex);
+		extern bool ReplayMove(BitBoard& pBoard, BitBoard& pNextBoard);
+		extern int GetMoveSAN(BitBoard& pBoard, char pSAN[]);
 		extern bool Move(const int pFromIndex, const int pToIndex, BitBoard& pBoard, const helper::PawnPromotionEnum pPawnPromotionPiece, const bool pValidateEnabled, const bool pCommit);
 		extern bool Arrange(const int pFromIndex, const int pToIndex, BitBoard& pBoard);
 		extern bool ArrangeUpdate(const char pFen, const int pToIndex, BitBoard& pBoard);
@@ -0,0 +1,135 @@
+/*
+Karuah Chess is a chess playing program
+Copyright (C) 2020-2023 Karuah Software
+
+Karuah Chess is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Karuah Chess is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "perft.h"
+#include "moverules.h"
+#include "helper.h"
+#include "sf_perft.h"
+#include "sf_engine.h"
+#include <atomic>
+#include <memory>
+
+namespace KaruahChess {
+	namespace Perft {
+
+		/// <summary>
+		/// Gets the promotion piece of a move. Moves that are not promotions ignore the promotion piece.
+		/// </summary>
+		helper::PawnPromotionEnum promotionPiece(const int pPromotionPieceType)
+		{
+			return pPromotionPieceType > 0 ? (helper::PawnPromotionEnum)pPromotionPieceType : helper::PawnPromotionEnum::Queen;
+		}
+
+
+		/// <summary>
+		/// Counts the leaf nodes below the board to the given depth. Moves of the last ply are counted without making them.
+		/// </summary>
+		uint64_t Count(BitBoard& pBoard, const int pDepth, Stockfish::Benchmark::PerftHash* pHash)
+		{
+			// The board is the only node at depth 0
+			if (pDepth <= 0) return 1;
+
+			MoveRules::MoveList moveList;
+			MoveRules::GenerateLegalMoves(pBoard, moveList);
+			if (pDepth <= 1) return uint64_t(moveList.count);
+
+			uint64_t nodes = 0;
+			uint64_t key = 0;
+			if (pHash != nullptr) {
+				key = pBoard.PositionKey();
+				if (pHash->probe(key, pDepth, nodes)) return nodes;
+			}
+
+			MoveUndo undo;
+			for (int i = 0; i < moveList.count; i++) {
+				const MoveRules::MoveListItem& move = moveList.moves[i];
+				pBoard.MakeMove(move.fromIndex, move.toIndex, promotionPiece(move.promotionPieceType), undo);
+				nodes += Count(pBoard, pDepth - 1, pHash);
+				pBoard.UnmakeMove(undo);
+			}
+
+			if (pHash != nullptr) pHash->store(key, pDepth, nodes);
+
+			return nodes;
+		}
+
+
+		/// <summary>
+		/// Counts the leaf nodes of each root move with the root moves split across the search threads of the engine.
+		/// A perft hash of pHashMB megabytes is shared by the threads when pHashMB is not zero.
+		/// </summary>
+		uint64_t Divide(Stockfish::Engine& pEngine, BitBoard& pBoard, const int pDepth, const size_t pHashMB, std::vector<PerftDivideItem>& pDivide)
+		{
+			pDivide.clear();
+			if (pDepth <= 0) return 1;
+
+			MoveRules::MoveList moveList;
+			MoveRules::GenerateLegalMoves(pBoard, moveList);
+
+			for (int i = 0; i < moveList.count; i++) {
+				const MoveRules::MoveListItem& move = moveList.moves[i];
+				pDivide.push_back({ move.fromIndex, move.toIndex, move.promotionPieceType, pDepth <= 1 ? 1ULL : 0ULL });
+			}
+
+			if (pDepth > 1) {
+				std::unique_ptr<Stockfish::Benchmark::PerftHash> hash;
+				if (pHashMB > 0) hash = std::make_unique<Stockfish::Benchmark::PerftHash>(pHashMB);
+
+				// Each thread works on its own copy of the board and takes the next root move until none are left
+				std::atomic<size_t> next(0);
+				pEngine.run_on_threads([&](size_t) {
+					BitBoard board;
+					pBoard.Copy(board);
+
+					MoveUndo undo;
+					for (size_t k = next++; k < pDivide.size(); k = next++) {
+						PerftDivideItem& item = pDivide[k];
+						board.MakeMove(item.fromIndex, item.toIndex, promotionPiece(item.promotionPieceType), undo);
+						item.nodes = Count(board, pDepth - 1, hash.get());
+						board.UnmakeMove(undo);
+					}
+				});
+			}
+
+			uint64_t nodes = 0;
+			for (const PerftDivideItem& item : pDivide) {
+				nodes += item.nodes;
+			}
+
+			return nodes;
+		}
+
+
+		/// <summary>
+		/// Gets the move in UCI notation, eg e2e4 or e7e8q
+		/// </summary>
+		std::string MoveUCI(const PerftDivideItem& pItem)
+		{
+			std::string move;
+			for (int index : { pItem.fromIndex, pItem.toIndex }) {
+				move += char('a' + index % 8);
+				move += char('8' - index / 8);
+			}
+			if (pItem.promotionPieceType > 0) move += " pnbrqk"[pItem.promotionPieceType];
+
+			return move;
+		}
+
+	}
+
+}
@@ -0,0 +1,50 @@
+/*
+Karuah Chess is a chess playing program
+Copyright (C) 2020-2023 Karuah Software
+
+Karuah Chess is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Karuah Chess is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "bitboard.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Stockfish {
+	class Engine;
+
+	namespace Benchmark {
+		class PerftHash;
+	}
+}
+
+namespace KaruahChess {
+	namespace Perft {
+
+		// Node count of a root move
+		struct PerftDivideItem {
+			int fromIndex = -1;
+			int toIndex = -1;
+			int promotionPieceType = 0;
+			uint64_t nodes = 0;
+		};
+
+		extern uint64_t Count(BitBoard& pBoard, const int pDepth, Stockfish::Benchmark::PerftHash* pHash);
+		extern uint64_t Divide(Stockfish::Engine& pEngine, BitBoard& pBoard, const int pDepth, const size_t pHashMB, std::vector<PerftDivideItem>& pDivide);
+		extern std::string MoveUCI(const PerftDivideItem& pItem);
+	}
+
+}
@@ -27,9 +27,22 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "sf_uci.h"
 #include "sf_types.h"
 #include "sf_search.h"
+#include <algorithm>
 #include <chrono>
+#include <string>
+#include <type_traits>
 #include <time.h>
 #include <random>
+#include <unordered_map>
+#include <utility>
+#include <exception>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 
 namespace KaruahChess {
@@ -38,20 +51,118 @@ namespace KaruahChess {
 
         using namespace helper;
 
-        bool _cancel = false;
+        /// <summary>
+        /// Mixes a value into a hash
+        /// </summary>
+        uint64_t mixHash(uint64_t pHash, uint64_t pValue) {
+            uint64_t h = (pHash ^ pValue) + 0x9E3779B97F4A7C15ULL;
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            return h ^ (h >> 31);
+        }
+
+
+        /// <summary>
+        /// Gets the result cache key of a search. The key combines the position, the positions since the last
+        /// capture or pawn move which the engine uses for repetition, and the search options.
+        /// </summary>
+        uint64_t resultCacheKey(BitBoard& pBoard, const SearchOptions& pSearchOptions) {
+            uint64_t key = pBoard.PositionKey();
+
+            const std::vector<MoveHistoryItem>& history = pBoard.GetMoveHistory();
+            int historySize = (int)history.size();
+            int oldest = std::max(0, historySize - pBoard.StateHalfMoveCount);
+            for (int i = oldest; i < historySize; i++) {
+                key = mixHash(key, history[i].positionKey);
+            }
+
+            key = mixHash(key, (uint64_t)(uint32_t)pSearchOptions.limitSkillLevel);
+            key = mixHash(key, (uint64_t)(uint32_t)pSearchOptions.limitDepth);
+            key = mixHash(key, (uint64_t)(uint32_t)pSearchOptions.limitNodes);
+            key = mixHash(key, (uint64_t)(uint32_t)pSearchOptions.limitMoveDuration);
+            key = mixHash(key, (uint64_t)(uint32_t)pSearchOptions.limitThreads);
+
+            return key;
+        }
+
+
+        /// <summary>
+        /// Finds a result in the cache
+        /// </summary>
+        bool resultCacheFind(SearchState& pState, uint64_t pKey, SearchTreeNode& pResult) {
+            std::lock_guard<std::mutex> lock(pState.resultCacheMutex);
+            auto indexItr = pState.resultCacheIndex.find(pKey);
+            if (indexItr == pState.resultCacheIndex.end()) {
+                pState.resultCacheStatistics.misses++;
+                return false;
+            }
+
+            ResultCacheEntry& entry = pState.resultCache[indexItr->second];
+            entry.referenced = true;
+            pResult = entry.result;
+            pState.resultCacheStatistics.hits++;
+            return true;
+        }
+
+
+        /// <summary>
+        /// Stores a result in the cache, replacing the first entry not referenced since the clock hand last passed
+        /// </summary>
+        void resultCacheStore(SearchState& pState, uint64_t pKey, const SearchTreeNode& pResult) {
+            std::lock_guard<std::mutex> lock(pState.resultCacheMutex);
+            if (pState.resultCacheIndex.empty()) pState.resultCacheIndex.reserve(RESULT_CACHE_SIZE);
+            if (pState.resultCacheIndex.count(pKey)) return;
+
+            while (pState.resultCache[pState.resultCacheHand].valid && pState.resultCache[pState.resultCacheHand].referenced) {
+                pState.resultCache[pState.resultCacheHand].referenced = false;
+                pState.resultCacheHand = (pState.resultCacheHand + 1) % RESULT_CACHE_SIZE;
+            }
+
+            ResultCacheEntry& entry = pState.resultCache[pState.resultCacheHand];
+            if (entry.valid) pState.resultCacheIndex.erase(entry.key);
+
+            entry.key = pKey;
+            entry.valid = true;
+            entry.referenced = false;
+            entry.result = pResult;
+            pState.resultCacheIndex[pKey] = pState.resultCacheHand;
+            pState.resultCacheHand = (pState.resultCacheHand + 1) % RESULT_CACHE_SIZE;
+        }
+
+
+        /// <summary>
+        /// Converts a Stockfish move to a Karuah Chess move packed as from index | to index << 6 | promotion piece << 12.
+        /// Castling in Stockfish is a king to rook move.
+        /// </summary>
+        uint16_t packMove(Stockfish::Move pMove) {
+            // Mirror the result as the karuah chess board is a mirror of
+            // the sf board
+            int fromIndex = helper::mirrorRank(pMove.from_sq());
+            int toIndex = helper::mirrorRank(pMove.to_sq());
+            int promotionPieceType = 0;
+
+            if (pMove.type_of() == Stockfish::CASTLING) {
+                toIndex = toIndex > fromIndex ? fromIndex + 2 : fromIndex - 2;
+            }
+            else if (pMove.type_of() == Stockfish::PROMOTION) {
+                promotionPieceType = pMove.promotion_type();
+            }
+
+            return uint16_t(fromIndex | (toIndex << 6) | (promotionPieceType << 12));
+        }
 
 
         /// <summary>
         /// Sets an option in stock fish if the option is different from the current option
         /// </summary>
-        void setOption(std::string name, int value) {
+        void setOption(Engine::Context& pContext, std::string name, int value) {
 
-            if (Engine::mainUCI->engine_options().count(name)) {
-                double currentValue = Engine::mainUCI->engine_options()[name];
+            if (pContext.uci().engine_options().count(name)) {
+                double currentValue = pContext.uci().engine_options()[name];
                 double newValue = (double)value;
 
                 if (currentValue != newValue) {
-                    Engine::mainUCI->engine_options()[name] = std::to_string(value);
+                    pContext.uci().engine_options()[name] = std::to_string(value);
                 }
             }
 
@@ -59,140 +170,597 @@ namespace KaruahChess {
 
 
         /// <summary>
-        /// Gets top move for a given board
+        /// Converts a principal variation record from the engine to search progress
         /// </summary>
-        void GetBestMove(BitBoard& pBoard, SearchOptions pSearchOptions, SearchTreeNode& pBestMove, SearchStatistics& pStatistics)
-        {
+        SearchProgress toProgress(const Stockfish::Search::InfoRecord& pInfo) {
+            SearchProgress progress;
+
+            progress.depth = pInfo.depth;
+            progress.selDepth = pInfo.selDepth;
+            progress.multiPV = pInfo.multiPV;
 
-            _cancel = false;
+            pInfo.score.visit([&progress](auto pScore) {
+                using ScoreType = decltype(pScore);
+                if constexpr (std::is_same_v<ScoreType, Stockfish::Score::Mate>) {
+                    progress.mate = pScore.plies > 0 ? (pScore.plies + 1) / 2 : pScore.plies / 2;
+                }
+                else if constexpr (std::is_same_v<ScoreType, Stockfish::Score::Tablebase>) {
+                    progress.score = pScore.win ? 20000 - pScore.plies : -20000 - pScore.plies;
+                }
+                else {
+                    progress.score = pScore.value;
+                }
+            });
 
-            pStatistics.StartTime = std::chrono::steady_clock::now();
+            progress.wdlWin = pInfo.wdl[0];
+            progress.wdlDraw = pInfo.wdl[1];
+            progress.wdlLoss = pInfo.wdl[2];
 
-            // Don't perform a search if the engine can't cope with the board configuration
-            int searchError = pBoard.VerifyBoardConfiguration();
+            progress.nodes = pInfo.nodes;
+            progress.nps = pInfo.nps;
+            progress.hashFull = pInfo.hashfull;
+            progress.timeMS = (int)pInfo.timeMs;
 
-            // Check for engine errors.
-            if (Engine::engineErr.errorList.size() > 0) {
-                searchError = Engine::engineErr.errorList[0]; // Get the first error.
+            progress.pvLength = std::min(pInfo.pvLength, MAX_PV);
+            for (int i = 0; i < progress.pvLength; i++) {
+                progress.pv[i] = packMove(pInfo.pv[i]);
             }
 
-            if (searchError == 0) {
+            return progress;
+        }
+
 
-                // Clear the cache if starting a new game
-                if (pBoard.StateFullMoveCount == 0) {
-                    ClearCache();
+        /// <summary>
+        /// Converts the root move chosen by the engine to a search result
+        /// </summary>
+        void toBestMove(const Stockfish::Search::RootMove& pRootMove, SearchTreeNode& pBestMove) {
+            Stockfish::Move m = pRootMove.pv[0];
+
+            if (m == Stockfish::Move::none() || m == Stockfish::Move::null()) {
+                // No move found
+                pBestMove.moveFromIndex = -1;
+                pBestMove.moveToIndex = -1;
+            }
+            else {
+                uint16_t move = packMove(m);
+                pBestMove.moveFromIndex = move & 0x3F;
+                pBestMove.moveToIndex = (move >> 6) & 0x3F;
+                pBestMove.promotionPieceType = move >> 12;
+
+                // Score and principal variation
+                pBestMove.score = pRootMove.score;
+                pBestMove.pvLength = std::min((int)pRootMove.pv.size(), MAX_PV);
+                for (int i = 0; i < pBestMove.pvLength; i++) {
+                    pBestMove.pv[i] = packMove(pRootMove.pv[i]);
                 }
+            }
+        }
+
+
+        /// <summary>
+        /// Stops the search that is running
+        /// </summary>
+        void cancelSearch(Engine::Context& pContext) {
+            pContext.searchState().cancel = true;
+            pContext.uci().engine.stop();
+        }
+
+
+        /// <summary>
+        /// Stops the ponder search and the speculative searches. Called holding the start mutex.
+        /// </summary>
+        void stopBackground(Engine::Context& pContext) {
+            SearchState& state = pContext.searchState();
 
-                // Thread limit
-                setOption("Threads", pSearchOptions.limitThreads);
+            bool running = false;
+            if (std::shared_ptr<std::atomic<bool>> stopped = std::exchange(state.speculationStopped, nullptr)) {
+                *stopped = true;
+                running = true;
+            }
+            if (std::exchange(state.ponderSession, nullptr)) {
+                running = true;
+            }
+
+            if (running) cancelSearch(pContext);
+        }
+
+
+        /// <summary>
+        /// Clears the transposition table and the result cache. Called holding the start mutex.
+        /// </summary>
+        void clearCache(Engine::Context& pContext) {
+            SearchState& state = pContext.searchState();
 
-                // Set options
-                if (pSearchOptions.limitSkillLevel >= -10 && pSearchOptions.limitSkillLevel < 20) {
-                    // Set engine strength             
-                    setOption("Skill Level", pSearchOptions.limitSkillLevel);
+            pContext.uci().engine.search_clear();
+
+            {
+                std::lock_guard<std::mutex> lock(state.resultCacheMutex);
+                for (ResultCacheEntry& entry : state.resultCache) {
+                    entry.valid = false;
+                    entry.referenced = false;
                 }
-                else {
-                    // Set engine to max
-                    setOption("Skill Level", 20);
+                state.resultCacheIndex.clear();
+                state.resultCacheHand = 0;
+            }
+            state.expectedReply = 0;
+        }
+
+
+        /// <summary>
+        /// Lowers the scheduling priority of the search threads, or restores it. The priority is only lowered
+        /// where it can be restored without privileges.
+        /// </summary>
+        void setBackgroundPriority(Engine::Context& pContext, bool pBackground) {
+            SearchState& state = pContext.searchState();
+            if (!pBackground && !state.backgroundPriority) return;
+
+#if defined(__linux__)
+            pContext.uci().engine.run_on_threads([pBackground](size_t) {
+                static thread_local bool lowered = false;
+                static thread_local int normalNice = 0;
+
+                id_t tid = (id_t)syscall(SYS_gettid);
+                if (pBackground && !lowered) {
+                    errno = 0;
+                    int nice = getpriority(PRIO_PROCESS, tid);
+                    rlimit limit;
+                    if (errno == 0 && getrlimit(RLIMIT_NICE, &limit) == 0 && (limit.rlim_cur == RLIM_INFINITY || 20 - nice <= (int)limit.rlim_cur)
+                        && setpriority(PRIO_PROCESS, tid, std::min(nice + BACKGROUND_NICE, 19)) == 0) {
+                        normalNice = nice;
+                        lowered = true;
+                    }
                 }
-                                
-                
-                if (pSearchOptions.randomiseFirstMove && pBoard.StateFullMoveCount < 1) {
-                    // For the first move look at 4 different possibilities for openings
-                    // to make the game more interesting
-                    setOption("MultiPV", 5);
+                else if (!pBackground && lowered) {
+                    setpriority(PRIO_PROCESS, tid, normalNice);
+                    lowered = false;
                 }
-                else if (pSearchOptions.alternateMove) {
-                    // Attempt to avoid repetitions
-                    setOption("MultiPV", 2);
+                });
+#endif
+
+            state.backgroundPriority = pBackground;
+        }
+
+
+        /// <summary>
+        /// Coroutine type of the speculative searches, it runs until it finishes without being awaited
+        /// </summary>
+        struct SpeculationTask {
+            struct promise_type {
+                SpeculationTask get_return_object() { return {}; }
+                std::suspend_never initial_suspend() { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+
+        SearchSession::SearchSession(Engine::Context& pContext, Kind pKind) :
+            context(pContext),
+            kind(pKind),
+            infoQueue(std::make_shared<Stockfish::Search::InfoQueue>()),
+            result(promise.get_future().share())
+        {
+        }
+
+
+        /// <summary>
+        /// Starts a search for the top move of a given board
+        /// </summary>
+        std::shared_ptr<SearchSession> SearchSession::Start(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress)
+        {
+            SearchState& state = pContext.searchState();
+
+            {
+                std::lock_guard<std::mutex> lock(state.startMutex);
+
+                // If the user played the expected reply the ponder search becomes the search of the move
+                std::shared_ptr<SearchSession> ponder = state.ponderSession;
+                if (ponder && ponder->pondering && ponder->cacheKey == resultCacheKey(pBoard, pSearchOptions)) {
+                    state.ponderSession = nullptr;
+                    ponder->PonderHit();
+                    return ponder;
                 }
-                else {
-                    setOption("MultiPV", 1);
+
+                // Otherwise the background searches are stopped, the transposition table keeps what they found
+                stopBackground(pContext);
+            }
+
+            return start(pContext, pBoard, pSearchOptions, pOnProgress, Kind::Search);
+        }
+
+
+        /// <summary>
+        /// Starts a search of the position after the reply expected to the last move of the engine. The board
+        /// is the position after that move. Returns nullptr if there is no reply to ponder on.
+        /// </summary>
+        std::shared_ptr<SearchSession> SearchSession::Ponder(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress)
+        {
+            SearchState& state = pContext.searchState();
+
+            {
+                std::lock_guard<std::mutex> lock(state.startMutex);
+                stopBackground(pContext);
+            }
+
+            // The expected reply is set when the search of the engine move finishes
+            pContext.uci().engine.wait_for_search_finished();
+
+            uint16_t reply = state.expectedReply;
+            if (reply == 0) return nullptr;
+
+            BitBoard ponderBoard;
+            pBoard.Copy(ponderBoard);
+
+            int promotionPieceType = reply >> 12;
+            helper::PawnPromotionEnum promotion = promotionPieceType > 0 ? helper::PawnPromotionEnum(promotionPieceType) : helper::PawnPromotionEnum::Queen;
+            if (!MoveRules::Move(reply & 0x3F, (reply >> 6) & 0x3F, ponderBoard, promotion, true, true)) {
+                return nullptr;
+            }
+
+            return start(pContext, ponderBoard, pSearchOptions, pOnProgress, Kind::Ponder);
+        }
+
+
+        /// <summary>
+        /// Starts searching the replies to the moves the user is most likely to play. The board is the position
+        /// with the user to move. Returns straight away, the searches run one after the other on the dispatcher
+        /// thread and stop when another search starts.
+        /// </summary>
+        void SearchSession::Speculate(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, int pCandidates)
+        {
+            SearchState& state = pContext.searchState();
+            auto stopped = std::make_shared<std::atomic<bool>>(false);
+
+            {
+                std::lock_guard<std::mutex> lock(state.startMutex);
+                stopBackground(pContext);
+                state.speculationStopped = stopped;
+            }
+
+            auto board = std::make_shared<BitBoard>();
+            pBoard.Copy(*board);
+
+            // The coroutine frame holds the parameters, the lambda captures nothing
+            [](Engine::Context& pContext, std::shared_ptr<BitBoard> pBoard, SearchOptions pSearchOptions, int pCandidates, std::shared_ptr<std::atomic<bool>> pStopped) -> SpeculationTask {
+                // Rank the moves of the user with a short search of the position
+                SearchOptions rankOptions;
+                rankOptions.limitSkillLevel = 20;
+                rankOptions.limitDepth = SPECULATE_RANK_DEPTH;
+                rankOptions.limitThreads = pSearchOptions.limitThreads;
+
+                std::shared_ptr<SearchSession> rank = start(pContext, *pBoard, rankOptions, nullptr, Kind::Speculative, pCandidates, pStopped);
+                SearchSessionResult ranked = co_await *rank;
+
+                // The replies are searched with the options of the real search, so a finished search is a
+                // result cache hit when the user plays the move
+                int count = std::min((int)ranked.candidates.size(), pCandidates);
+                for (int i = 0; i < count && !*pStopped; i++) {
+                    BitBoard board;
+                    pBoard->Copy(board);
+
+                    uint16_t move = ranked.candidates[i];
+                    int promotionPieceType = move >> 12;
+                    helper::PawnPromotionEnum promotion = promotionPieceType > 0 ? helper::PawnPromotionEnum(promotionPieceType) : helper::PawnPromotionEnum::Queen;
+                    if (!MoveRules::Move(move & 0x3F, (move >> 6) & 0x3F, board, promotion, true, true)) continue;
+
+                    std::shared_ptr<SearchSession> reply = start(pContext, board, pSearchOptions, nullptr, Kind::Speculative, 0, pStopped);
+                    co_await *reply;
                 }
+            }(pContext, board, pSearchOptions, pCandidates, stopped);
+        }
 
-                // Get the board position            
-                std::string fullFEN = pBoard.GetFullFEN();
 
-                // Set the position            
-                std::vector<std::string> moves;
-                Engine::mainUCI->engine.set_position(fullFEN, moves);
+        /// <summary>
+        /// Starts a search. A ponder search waits for PonderHit before it stops at the limits. A speculative search
+        /// runs at low priority and does not start once it is stopped. A MultiPV of zero is set from the options.
+        /// </summary>
+        std::shared_ptr<SearchSession> SearchSession::start(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress, Kind pKind, int pMultiPV, std::shared_ptr<std::atomic<bool>> pStopped)
+        {
+            std::shared_ptr<SearchSession> session(new SearchSession(pContext, pKind));
+            SearchState& state = pContext.searchState();
+            Stockfish::Engine& engine = pContext.uci().engine;
 
-                // Do the search
-                Stockfish::Search::LimitsType limits;
-                limits.startTime = Stockfish::now();
+            std::lock_guard<std::mutex> lock(state.startMutex);
 
-                // Set the limits from the GUI
-                limits.depth = pSearchOptions.limitDepth;
-                limits.nodes = pSearchOptions.limitNodes;
-                limits.movetime = pSearchOptions.limitMoveDuration;
-                
+            session->statistics.StartTime = std::chrono::steady_clock::now();
+
+            SearchTreeNode bestMove;
+
+            if (pStopped && *pStopped) {
+                bestMove.cancelled = true;
+                session->finish(bestMove);
+                return session;
+            }
+
+            // The search of a previous session may still be finishing
+            engine.wait_for_search_finished();
+
+            state.cancel = false;
+
+            // Don't perform a search if the engine can't cope with the board configuration
+            int searchError = pBoard.VerifyBoardConfiguration();
+
+            // Check for engine errors.
+            int engineError = Engine::engineErr.first(); // Get the first error.
+            if (engineError != 0) {
+                searchError = engineError;
+            }
+
+            if (searchError != 0) {
+                bestMove.error = searchError;
+                session->finish(bestMove);
+                return session;
+            }
+
+            // Clear the cache if starting a new game
+            if (pBoard.StateFullMoveCount == 0) {
+                clearCache(pContext);
+            }
+
+            // Thread limit
+            setOption(pContext, "Threads", pSearchOptions.limitThreads);
+
+            // Speculative searches give way to the rest of the app
+            setBackgroundPriority(pContext, pKind == Kind::Speculative);
+
+            // Set options
+            if (pSearchOptions.limitSkillLevel >= -10 && pSearchOptions.limitSkillLevel < 20) {
+                // Set engine strength             
+                setOption(pContext, "Skill Level", pSearchOptions.limitSkillLevel);
+            }
+            else {
+                // Set engine to max
+                setOption(pContext, "Skill Level", 20);
+            }
+                                
                 
-                std::vector<Stockfish::Search::RootMove> rootmoves;
-                Engine::mainUCI->engine.set_on_bestmove([&rootmoves](const auto& bm, const auto& p, const auto& rm) {
-                    rootmoves = rm;
+            if (pMultiPV > 0) {
+                setOption(pContext, "MultiPV", pMultiPV);
+            }
+            else if (pSearchOptions.randomiseFirstMove && pBoard.StateFullMoveCount < 1) {
+                // For the first move look at 4 different possibilities for openings
+                // to make the game more interesting
+                setOption(pContext, "MultiPV", 5);
+            }
+            else {
+                setOption(pContext, "MultiPV", 1);
+            }
+
+            // Use the result of an earlier search of the same position with the same options.
+            // Randomised first moves and searches for more than one line are not cached.
+            bool randomise = pSearchOptions.randomiseFirstMove && pBoard.StateFullMoveCount < 1;
+            bool cached = !randomise && pMultiPV == 0;
+            uint64_t cacheKey = resultCacheKey(pBoard, pSearchOptions);
+            session->cacheKey = cacheKey;
+            if (cached && resultCacheFind(state, cacheKey, bestMove)) {
+                session->finish(bestMove);
+                return session;
+            }
+
+            // Set the position directly from the board, with the moves since the last capture
+            // or pawn move so the engine can see repetitions
+            Stockfish::PositionSetup positionSetup;
+            std::vector<Stockfish::Move> moves;
+            Engine::toPositionSetup(pBoard, positionSetup, moves);
+            engine.set_position(positionSetup, moves);
+
+            // Do the search
+            Stockfish::Search::LimitsType limits;
+            limits.startTime = Stockfish::now();
+
+            // Set the limits from the GUI
+            limits.depth = pSearchOptions.limitDepth;
+            limits.nodes = pSearchOptions.limitNodes;
+            limits.movetime = pSearchOptions.limitMoveDuration;
+
+            // The limits apply once the ponder search has a ponder hit, the time spent pondering counts
+            limits.ponderMode = pKind == Kind::Ponder;
+            session->pondering = limits.ponderMode;
+
+            // Registered while the start lock is held so a Start that follows can take the ponder hit
+            if (pKind == Kind::Ponder) state.ponderSession = session;
+
+            // The search publishes its progress to the queue of the session and carries on, the
+            // progress is read from the queue on the dispatcher thread or by polling
+            engine.set_info_queue(session->infoQueue);
+            if (pOnProgress) {
+                state.dispatcher.Post([queue = session->infoQueue, pOnProgress]() {
+                    Stockfish::Search::InfoRecord record;
+                    while (queue->wait_pop(record)) {
+                        if (record.kind == Stockfish::Search::InfoRecord::Full) pOnProgress(toProgress(record));
+                    }
                     });
-                Engine::mainUCI->engine.go(limits);
-                Engine::mainUCI->engine.wait_for_search_finished();
-               
+            }
+
+            engine.set_on_bestmove([session, &engine, &state, cacheKey, randomise, cached](const auto&, const auto&, const auto& rootmoves) {
+                // Later searches without a session report through the callbacks again
+                engine.set_info_queue(nullptr);
+
                 int rootIndex = 0;
-                if (pSearchOptions.randomiseFirstMove && pBoard.StateFullMoveCount < 1 && rootmoves.size() >= 5) {
+                if (randomise && rootmoves.size() >= 5) {
                     // Randomiser for first move
                     auto rd = std::random_device{};
                     std::mt19937 gen(rd());
                     std::uniform_int_distribution<> distrib(0, 4);
                     rootIndex = distrib(gen);
                 }
-                else if (pSearchOptions.alternateMove && rootmoves.size() >= 2) {
-                    // Alternate move selector, attempt to avoid repetition
-                    rootIndex = 1;
-                }
-
-                Stockfish::Move m = rootmoves[rootIndex].pv[0];
-                                
-                // Mirror the result as the karuah chess board is a mirror of
-                // the sf board
-                const int fromIndex = helper::mirrorRank(m.from_sq());
-                const int toIndex = helper::mirrorRank(m.to_sq());
 
+                SearchTreeNode bestMove;
+                toBestMove(rootmoves[rootIndex], bestMove);
 
-                if (m == Stockfish::Move::none() || m == Stockfish::Move::null()) {
-                    // No move found
-                    pBestMove.moveFromIndex = -1;
-                    pBestMove.moveToIndex = -1;
+                if (bestMove.moveFromIndex >= 0 && cached && !state.cancel) {
+                    resultCacheStore(state, cacheKey, bestMove);
                 }
-                else if (m.type_of() == Stockfish::CASTLING) {
-                    pBestMove.moveFromIndex = fromIndex;
 
-                    // Set up the castling move
-                    if (fromIndex == 4) {
-                        pBestMove.moveToIndex = toIndex > fromIndex ? 6 : 2;
-                    }
-                    else if (fromIndex == 60) {
-                        pBestMove.moveToIndex = toIndex > fromIndex ? 62 : 58;
-                    }
-                }
-                else if (m.type_of() == Stockfish::PROMOTION) {
-                    // Set the promotion piece
-                    pBestMove.promotionPieceType = m.promotion_type();
-                    pBestMove.moveFromIndex = fromIndex;
-                    pBestMove.moveToIndex = toIndex;
+                // The root moves best first, the first MultiPV of them are ranked by a full search
+                std::vector<uint16_t> candidates;
+                for (size_t i = 0; i < rootmoves.size() && i < (size_t)MAX_PV; i++) {
+                    if (rootmoves[i].pv[0] != Stockfish::Move::none()) candidates.push_back(packMove(rootmoves[i].pv[0]));
                 }
-                else {
-                    pBestMove.moveFromIndex = fromIndex;
-                    pBestMove.moveToIndex = toIndex;
+
+                session->finish(bestMove, std::move(candidates));
+                });
+
+            engine.go(limits);
+
+            return session;
+        }
+
+
+        /// <summary>
+        /// Checks if the result is available
+        /// </summary>
+        bool SearchSession::IsFinished() const
+        {
+            std::lock_guard<std::mutex> lock(finishMutex);
+            return finished;
+        }
+
+
+        /// <summary>
+        /// Reads the next progress of the search, returns false if there is none yet. For sessions started
+        /// without a progress callback.
+        /// </summary>
+        bool SearchSession::PollProgress(SearchProgress& pProgress)
+        {
+            Stockfish::Search::InfoRecord record;
+            while (infoQueue->pop(record)) {
+                if (record.kind == Stockfish::Search::InfoRecord::Full) {
+                    pProgress = toProgress(record);
+                    return true;
                 }
+            }
+            return false;
+        }
 
-                 
+
+        /// <summary>
+        /// Stops the search, the result is the best move found so far
+        /// </summary>
+        void SearchSession::Cancel()
+        {
+            Search::Cancel(context);
+        }
+
+
+        /// <summary>
+        /// The user played the reply that is being pondered, the search carries on as a normal search
+        /// </summary>
+        void SearchSession::PonderHit()
+        {
+            if (!pondering.exchange(false)) return;
+
+            // The response time is from the move of the user. The statistics are completed by finish on the search thread.
+            {
+                std::lock_guard<std::mutex> lock(finishMutex);
+                if (!finished) statistics.StartTime = std::chrono::steady_clock::now();
             }
-            else {
-                pBestMove.error = searchError;
+            context.uci().engine.set_ponderhit(false);
+        }
+
+
+        /// <summary>
+        /// Adds a coroutine to resume when the search has finished. Returns false if it has already finished.
+        /// </summary>
+        bool SearchSession::addContinuation(std::coroutine_handle<> pHandle)
+        {
+            std::lock_guard<std::mutex> lock(finishMutex);
+            if (finished) return false;
+
+            continuations.push_back(pHandle);
+            return true;
+        }
+
+
+        /// <summary>
+        /// Sets the result and resumes the coroutines waiting for it on the dispatcher thread
+        /// </summary>
+        void SearchSession::finish(const SearchTreeNode& pBestMove, std::vector<uint16_t> pCandidates)
+        {
+            SearchTreeNode bestMove = pBestMove;
+            bestMove.cancelled = bestMove.cancelled || context.searchState().cancel;
+            pondering = false;
+
+            // The reply to ponder on after the move is made
+            if (kind != Kind::Speculative) {
+                context.searchState().expectedReply = (bestMove.moveFromIndex >= 0 && !bestMove.cancelled && bestMove.pvLength > 1) ? bestMove.pv[1] : 0;
+            }
+
+            // No more progress, the progress callback returns once it has the rest
+            infoQueue->close();
+
+            std::vector<std::coroutine_handle<>> waiting;
+            {
+                std::lock_guard<std::mutex> lock(finishMutex);
+                statistics.EndTime = std::chrono::steady_clock::now();
+                statistics.DurationMS = std::chrono::duration_cast<std::chrono::milliseconds>(statistics.EndTime - statistics.StartTime);
+                promise.set_value({ bestMove, statistics, std::move(pCandidates) });
+                finished = true;
+                waiting.swap(continuations);
+            }
+
+            for (std::coroutine_handle<> handle : waiting) {
+                context.searchState().dispatcher.Post([handle]() { handle.resume(); });
+            }
+        }
+
+
+        SessionDispatcher::~SessionDispatcher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                exit = true;
+            }
+            queueCondition.notify_one();
+
+            if (thread.joinable()) thread.join();
+        }
+
+
+        /// <summary>
+        /// Queues a function to run on the dispatcher thread
+        /// </summary>
+        void SessionDispatcher::Post(std::function<void()> pFunction)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(std::move(pFunction));
+                if (!thread.joinable()) thread = std::thread(&SessionDispatcher::run, this);
             }
+            queueCondition.notify_one();
+        }
 
-            pStatistics.EndTime = std::chrono::steady_clock::now();
-            pStatistics.DurationMS = std::chrono::duration_cast<std::chrono::milliseconds>(pStatistics.EndTime - pStatistics.StartTime);
-            pBestMove.cancelled = _cancel;
 
+        /// <summary>
+        /// Runs the queued functions until the dispatcher is destroyed
+        /// </summary>
+        void SessionDispatcher::run()
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (true) {
+                queueCondition.wait(lock, [this]() { return exit || !queue.empty(); });
+                if (queue.empty()) return;
+
+                std::function<void()> function = std::move(queue.front());
+                queue.pop_front();
 
+                lock.unlock();
+                function();
+                lock.lock();
+            }
+        }
+
+
+        /// <summary>
+        /// Gets top move for a given board
+        /// </summary>
+        void GetBestMove(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, SearchTreeNode& pBestMove, SearchStatistics& pStatistics)
+        {
+            SearchSessionResult result = SearchSession::Start(pContext, pBoard, pSearchOptions)->Result().get();
+
+            pBestMove = result.bestMove;
+            pStatistics = result.statistics;
         }
 
 
@@ -200,18 +768,39 @@ namespace KaruahChess {
         /// Reset
         /// </summary>
         /// <returns></returns>
-        void Cancel() {
-            _cancel = true;
-            Engine::mainUCI->engine.stop();
+        void Cancel(Engine::Context& pContext) {
+            // Stopping the search first releases a start that is waiting for it to finish
+            cancelSearch(pContext);
+
+            // The speculative searches would otherwise carry on with their next reply
+            std::lock_guard<std::mutex> lock(pContext.searchState().startMutex);
+            stopBackground(pContext);
         }
 
         /// <summary>
         /// Clears the cache
         /// </summary>
         /// <returns></returns>
-        void ClearCache()
+        void ClearCache(Engine::Context& pContext)
+        {
+            std::lock_guard<std::mutex> lock(pContext.searchState().startMutex);
+
+            // A ponder search only finishes when it is stopped
+            stopBackground(pContext);
+            clearCache(pContext);
+        }
+
+        /// <summary>
+        /// Gets the result cache counters
+        /// </summary>
+        /// <returns></returns>
+        SearchCacheStatistics GetCacheStatistics(Engine::Context& pContext)
         {
-            Engine::mainUCI->engine.search_clear();
+            SearchState& state = pContext.searchState();
+            std::lock_guard<std::mutex> lock(state.resultCacheMutex);
+            SearchCacheStatistics statistics = state.resultCacheStatistics;
+            statistics.size = (int)state.resultCacheIndex.size();
+            return statistics;
         }
 
     }
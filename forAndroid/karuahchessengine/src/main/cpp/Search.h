@@ -19,13 +19,38 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 #include "helper.h"
 #include "bitboard.h"
+#include "engine.h"
 #include <cstdint>
 #include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaring class
+namespace Stockfish::Search {
+	class InfoQueue;
+}
 
 namespace KaruahChess {
 
 	namespace Search {
 
+		constexpr int MAX_PV = 32;
+		constexpr int RESULT_CACHE_SIZE = 256;
+
+		// Speculative searches, see SearchSession::Speculate
+		constexpr int SPECULATE_CANDIDATES = 3;
+		constexpr int SPECULATE_RANK_DEPTH = 8;
+		constexpr int BACKGROUND_NICE = 10;
+
 		struct SearchTreeNode {
 
 			int moveFromIndex = -1;
@@ -34,6 +59,18 @@ namespace KaruahChess {
 			bool cancelled = false;
 			int error = 0;
 
+			// Engine score and principal variation. Moves are packed as from index | to index << 6 | promotion piece << 12.
+			int score = 0;
+			int pvLength = 0;
+			uint16_t pv[MAX_PV] = {};
+
+		};
+
+		struct SearchCacheStatistics {
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			int size = 0;
+			int capacity = RESULT_CACHE_SIZE;
 		};
 
 		struct SearchStatistics {
@@ -50,16 +87,178 @@ namespace KaruahChess {
 			int limitMoveDuration = 0;
 			int limitThreads = 1;
 			bool randomiseFirstMove = false;
-			bool alternateMove = false;
 
 		};
 
+		/// <summary>
+		/// Progress of a search, reported each time the engine has a new principal variation
+		/// </summary>
+		struct SearchProgress {
+			int depth = 0;
+			int selDepth = 0;
+			int multiPV = 1;
+
+			// Score in centipawns from the side to move. When mate is not zero the side to move mates
+			// in that many moves, or is mated if it is negative.
+			int score = 0;
+			int mate = 0;
+
+			// Win, draw and loss chances of the side to move in per mille
+			int wdlWin = 0;
+			int wdlDraw = 0;
+			int wdlLoss = 0;
+
+			uint64_t nodes = 0;
+			uint64_t nps = 0;
+			int hashFull = 0;
+			int timeMS = 0;
+
+			// Moves are packed as from index | to index << 6 | promotion piece << 12.
+			int pvLength = 0;
+			uint16_t pv[MAX_PV] = {};
+		};
+
+		struct SearchSessionResult {
+			SearchTreeNode bestMove;
+			SearchStatistics statistics;
+
+			// The root moves best first, packed as the principal variation
+			std::vector<uint16_t> candidates;
+		};
+
+		/// <summary>
+		/// Runs functions in order on its own thread, which is started by the first function posted and
+		/// waits while there is nothing to run
+		/// </summary>
+		class SessionDispatcher {
+		public:
+			SessionDispatcher() = default;
+			~SessionDispatcher();
+
+			SessionDispatcher(const SessionDispatcher&) = delete;
+			SessionDispatcher& operator=(const SessionDispatcher&) = delete;
+
+			void Post(std::function<void()> pFunction);
+
+		private:
+			void run();
+
+			std::mutex queueMutex;
+			std::condition_variable queueCondition;
+			std::deque<std::function<void()>> queue;
+			bool exit = false;
+			std::thread thread;
+		};
+
+		/// <summary>
+		/// A search running on the threads of an engine context. Start returns as soon as the search is running,
+		/// the result is available from the future or by co_await on the session in a coroutine. The search publishes
+		/// its progress to a lock-free queue without waiting for the reader, the progress callback reads it on the
+		/// dispatcher thread of the context, or without a callback it can be read with PollProgress. The awaiting
+		/// coroutines are resumed on the dispatcher thread after the last progress, as a search thread cannot start
+		/// another search. A context runs one search at a time, starting a session waits for the search of the
+		/// previous session to finish.
+		///
+		/// Ponder starts a session on the position after the reply expected to the last move of the engine, which
+		/// searches while the user is thinking. When a session is then started on the position the user played,
+		/// the ponder session carries on as a normal timed search and is returned. On any other position it is
+		/// cancelled, the transposition table keeps what it found.
+		///
+		/// Speculate ranks the moves of the user with a short search and then searches the engine reply to each of
+		/// the best few, at low priority on the search threads of the context. The replies are searched with the
+		/// options of a normal search and go in to the result cache, so if the user plays one of the moves the reply
+		/// is immediate, or the search of it starts from a warm transposition table. Starting any other search stops
+		/// the speculative searches.
+		/// </summary>
+		class SearchSession : public std::enable_shared_from_this<SearchSession> {
+		public:
+			using ProgressCallback = std::function<void(const SearchProgress&)>;
+
+			static std::shared_ptr<SearchSession> Start(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress = nullptr);
+			static std::shared_ptr<SearchSession> Ponder(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress = nullptr);
+			static void Speculate(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, int pCandidates = SPECULATE_CANDIDATES);
+
+			std::shared_future<SearchSessionResult> Result() const { return result; }
+			bool IsFinished() const;
+			bool PollProgress(SearchProgress& pProgress);
+			void Cancel();
+			void PonderHit();
+
+			struct Awaiter {
+				std::shared_ptr<SearchSession> session;
+
+				bool await_ready() const { return session->IsFinished(); }
+				bool await_suspend(std::coroutine_handle<> pHandle) { return session->addContinuation(pHandle); }
+				SearchSessionResult await_resume() const { return session->result.get(); }
+			};
+
+			Awaiter operator co_await() { return { shared_from_this() }; }
+
+		private:
+			enum class Kind { Search, Ponder, Speculative };
+
+			SearchSession(Engine::Context& pContext, Kind pKind);
+
+			static std::shared_ptr<SearchSession> start(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, ProgressCallback pOnProgress, Kind pKind, int pMultiPV = 0, std::shared_ptr<std::atomic<bool>> pStopped = nullptr);
+			bool addContinuation(std::coroutine_handle<> pHandle);
+			void finish(const SearchTreeNode& pBestMove, std::vector<uint16_t> pCandidates = {});
+
+			Engine::Context& context;
+			Kind kind;
+			SearchStatistics statistics;
+			std::shared_ptr<Stockfish::Search::InfoQueue> infoQueue;
+			uint64_t cacheKey = 0ULL;
+			std::atomic<bool> pondering = false;
+
+			std::promise<SearchSessionResult> promise;
+			std::shared_future<SearchSessionResult> result;
+
+			mutable std::mutex finishMutex;
+			bool finished = false;
+			std::vector<std::coroutine_handle<>> continuations;
+		};
+
+		// Results of previous searches, replaced with the CLOCK algorithm
+		struct ResultCacheEntry {
+			uint64_t key = 0ULL;
+			bool valid = false;
+			bool referenced = false;
+			SearchTreeNode result;
+		};
+
+		/// <summary>
+		/// Search state of an engine context
+		/// </summary>
+		struct SearchState {
+			// Set by Cancel on the caller's thread, read on the search thread
+			std::atomic<bool> cancel = false;
+
+			// Held while the result cache or its statistics are read or changed
+			std::mutex resultCacheMutex;
+			ResultCacheEntry resultCache[RESULT_CACHE_SIZE];
+			std::unordered_map<uint64_t, int> resultCacheIndex;
+			int resultCacheHand = 0;
+			SearchCacheStatistics resultCacheStatistics;
+
+			// The reply expected to the move of the last search, packed as from index | to index << 6 | promotion piece << 12
+			std::atomic<uint16_t> expectedReply = 0;
+
+			// Held while a search is started, so the background searches are stopped before they can start
+			std::mutex startMutex;
+			std::shared_ptr<SearchSession> ponderSession;
+			std::shared_ptr<std::atomic<bool>> speculationStopped;
+			bool backgroundPriority = false;
+
+			SessionDispatcher dispatcher;
+		};
+
 		// Functions
-		extern void GetBestMove(BitBoard& pBoard, SearchOptions pSearchOptions, SearchTreeNode& pBestMove, SearchStatistics& pStatistics);
+		extern void GetBestMove(Engine::Context& pContext, BitBoard& pBoard, SearchOptions pSearchOptions, SearchTreeNode& pBestMove, SearchStatistics& pStatistics);
 
 
-		extern void Cancel();
-		extern void ClearCache();
+		extern void Cancel(Engine::Context& pContext);
+		extern void ClearCache(Engine::Context& pContext);
+		extern SearchCacheStatistics GetCacheStatistics(Engine::Context& pContext);
 	}
 
 }
\ No newline at end of file
@@ -61,6 +61,8 @@ namespace KaruahChess {
 		uint64_t DiagonalMoveXRay[64][4097]{ 0 };
 		uint64_t KnightMove[64]{ 0 };
 		uint64_t KingMove[64]{ 0 };
+		uint64_t BetweenMask[64][64]{ 0 };
+		uint64_t LineMask[64][64]{ 0 };
 
 
 		constexpr uint64_t BitScanMagic = 0x37E84A99DAE458F;
@@ -121,6 +123,25 @@ namespace KaruahChess {
 			}
 
 
+			// Between and line masks. Each ray is paired with the ray in the opposite direction.
+			uint64_t* rays[8] = { NorthRay, SouthRay, EastRay, WestRay, NorthWestRay, NorthEastRay, SouthWestRay, SouthEastRay };
+			int opposite[8] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+			for (int a = 0; a < 64; a++)
+			{
+				for (int b = 0; b < 64; b++)
+				{
+					for (int d = 0; d < 8; d++)
+					{
+						if ((rays[d][a] & (BITMASK >> b)) > 0)
+						{
+							BetweenMask[a][b] = rays[d][a] & rays[opposite[d]][b];
+							LineMask[a][b] = rays[d][a] | rays[opposite[d]][a] | (BITMASK >> a);
+							break;
+						}
+					}
+				}
+			}
+
 			CreateMoveLookupTable();
 
 			Initialised = true;
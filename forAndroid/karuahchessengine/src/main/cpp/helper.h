@@ -30,6 +30,7 @@ namespace KaruahChess {
 		enum class MoveTypeEnum : int { None = 0, Normal = 1, EnPassant = 2, Castle = 3, Promotion = 4 };
 		enum class BoardStatusEnum : int { Ready = 0, Checkmate = 1, Stalemate = 2, Resigned = 3 };
 		enum class PawnPromotionEnum : int { Knight = 2, Bishop = 3, Rook = 4, Queen = 5 };
+		enum class GameStatusEnum : int { None = 0, Checkmate = 1, Stalemate = 2, InsufficientMaterial = 3, FiftyMove = 4, Repetition = 5 };
 		enum class PatternEnum : int { Knight = 2, Bishop = 3, Rook = 4, Queen = 5 };
 
 		constexpr int BLACK_PAWN_INDEX = 0;
@@ -73,6 +74,7 @@ namespace KaruahChess {
 		constexpr uint64_t RANK8 = 0b11111111'00000000'00000000'00000000'00000000'00000000'00000000'00000000uLL;
 		constexpr uint64_t FILEA = 0b10000000'10000000'10000000'10000000'10000000'10000000'10000000'10000000uLL;
 		constexpr uint64_t FILEH = 0b00000001'00000001'00000001'00000001'00000001'00000001'00000001'00000001uLL;
+		constexpr uint64_t LIGHTSQUARES = 0b10101010'01010101'10101010'01010101'10101010'01010101'10101010'01010101uLL;
 
 
 
@@ -101,6 +103,11 @@ namespace KaruahChess {
 		constexpr int QUEEN_SPIN = 5;
 		constexpr int KING_SPIN = 6;
 
+		// FEN character and random board array offset of each spin, indexed by spin + 6
+		constexpr char FENCharBySpin[13] = { 'k', 'q', 'r', 'b', 'n', 'p', '0', 'P', 'N', 'B', 'R', 'Q', 'K' };
+		constexpr int Index64BySpin[13] = { BLACK_KING_INDEX_64, BLACK_QUEEN_INDEX_64, BLACK_ROOK_INDEX_64, BLACK_BISHOP_INDEX_64, BLACK_KNIGHT_INDEX_64, BLACK_PAWN_INDEX_64, 0,
+			WHITE_PAWN_INDEX_64, WHITE_KNIGHT_INDEX_64, WHITE_BISHOP_INDEX_64, WHITE_ROOK_INDEX_64, WHITE_QUEEN_INDEX_64, WHITE_KING_INDEX_64 };
+
 		// Colours
 		constexpr int WHITEPIECE = 1;
 		constexpr int BLACKPIECE = -1;
@@ -138,6 +145,8 @@ namespace KaruahChess {
 		extern uint64_t DiagonalMoveXRay[64][4097];
 		extern uint64_t KnightMove[64];
 		extern uint64_t KingMove[64];
+		extern uint64_t BetweenMask[64][64];
+		extern uint64_t LineMask[64][64];
 
 		extern const std::map<int, std::string> BoardCoordinateDict;
 
@@ -379,6 +388,17 @@ namespace KaruahChess {
 		};
 
 
+		/// <summary>
+		/// Unique random numbers for the board state. Side to move, castling availability and en passant file.
+		/// </summary>
+		constexpr uint64_t RandomStateArray[13] = {
+				15275597086478055876uLL,
+				7014606212777012463uLL,6762262440593178022uLL,4625939556625890470uLL,2268965188652517386uLL,
+				8195814392059175885uLL,5496642036444933715uLL,14510699991576891752uLL,2812438979781501224uLL,
+				9624758482909715360uLL,11495058094555135985uLL,5247575229808556397uLL,9144614735494951161uLL
+		};
+
+
 		// Returns the square index mirrored by rank
 		constexpr int mirrorRank(int pSqIndex) {
 			return pSqIndex ^ 56;
@@ -25,6 +25,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "search.h"
 #include "moverules.h"
 #include "sf_evaluate.h"
+#include <mutex>
 #include <unordered_map>
 
 using namespace KaruahChess;
@@ -32,6 +33,27 @@ using namespace KaruahChess;
 std::unordered_map<int, BitBoard*> MainBoardMap;
 std::unordered_map<int, BitBoard*> SearchBoardMap;
 
+// Each activity has its own engine context, shared by the engine objects of the activity.
+// The contexts share the networks and are kept for the life of the process.
+std::unordered_map<int, Engine::Context*> ContextMap;
+std::unordered_map<int, int> ActivityMap;
+std::mutex ContextMutex;
+
+
+/// <summary>
+/// Gets the engine context of an engine object, or nullptr if there is none
+/// </summary>
+Engine::Context* findContext(int pId)
+{
+    std::lock_guard<std::mutex> lock(ContextMutex);
+
+    auto activityItr = ActivityMap.find(pId);
+    if (activityItr == ActivityMap.end()) return nullptr;
+
+    auto contextItr = ContextMap.find(activityItr->second);
+    return contextItr != ContextMap.end() ? contextItr->second : nullptr;
+}
+
 
 /// <summary>
 /// Initialise helper function
@@ -42,39 +64,52 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_initialise (
         JNIEnv* pEnv,
         jobject pThis,
         jobject pAssetMgr,
+        jstring pCacheDir,
+        jint pActivityID,
         jint pId)
 {
     // Initialise with the NNUE file, if not already previously loaded
-    if (!(Engine::nnueLoadedBig && Engine::nnueLoadedSmall))
+    if (!Engine::sharedNetworks)
     {
         const char* nnueFileNameBig = "nn-1111cefa1111.nnue";
         const char* nnueFileNameSmall = "nn-37f18f62d772.nnue";
 
+        // The assets are only opened here for their length, they are read when the networks
+        // have not been converted to weight blobs in the cache directory
         AAssetManager *mgr = AAssetManager_fromJava(pEnv, pAssetMgr);
-        AAsset *nnueAssetBig = AAssetManager_open(mgr,nnueFileNameBig, AASSET_MODE_BUFFER);
-        AAsset *nnueAssetSmall = AAssetManager_open(mgr,nnueFileNameSmall, AASSET_MODE_BUFFER);
+        AAsset *nnueAssetBig = AAssetManager_open(mgr,nnueFileNameBig, AASSET_MODE_STREAMING);
+        AAsset *nnueAssetSmall = AAssetManager_open(mgr,nnueFileNameSmall, AASSET_MODE_STREAMING);
 
         if (nnueAssetBig != NULL && nnueAssetSmall != NULL) {
-            long nnueSizeBig = AAsset_getLength(nnueAssetBig);
-            char *nnueBufferBig = (char *) malloc(nnueSizeBig);
-            long nnueSizeSmall = AAsset_getLength(nnueAssetSmall);
-            char *nnueBufferSmall = (char *) malloc(nnueSizeSmall);
-
-            if (nnueBufferBig != NULL && nnueBufferSmall != NULL) {
-                AAsset_read(nnueAssetBig, nnueBufferBig, nnueSizeBig);
-                AAsset_read(nnueAssetSmall, nnueBufferSmall, nnueSizeSmall);
-                Engine::init(nnueFileNameBig, nnueBufferBig, nnueSizeBig, nnueFileNameSmall, nnueBufferSmall, nnueSizeSmall);
-                // Close the file asset
-                AAsset_close(nnueAssetBig);
-                AAsset_close(nnueAssetSmall);
-            } else {
-                Engine::engineErr.add(helper::NNUE_MEMORY_ALLOCATION_ERROR);
-            }
-
+            // The readers open the asset again as the big network is read in the background,
+            // the asset manager is kept by KaruahChessEngine for the life of the process
+            auto assetReader = [mgr](const char* pFileName) {
+                return [mgr, pFileName](char* pBuffer, long pSize) {
+                    AAsset *asset = AAssetManager_open(mgr, pFileName, AASSET_MODE_STREAMING);
+                    if (asset == NULL) return false;
+
+                    long total = 0;
+                    int count;
+                    while (total < pSize && (count = AAsset_read(asset, pBuffer + total, size_t(pSize - total))) > 0) total += count;
+
+                    AAsset_close(asset);
+                    return total == pSize;
+                };
+            };
+
+            const char* cacheDir = pEnv->GetStringUTFChars(pCacheDir, NULL);
+            Engine::init({nnueFileNameBig, long(AAsset_getLength(nnueAssetBig)), assetReader(nnueFileNameBig)},
+                         {nnueFileNameSmall, long(AAsset_getLength(nnueAssetSmall)), assetReader(nnueFileNameSmall)},
+                         cacheDir != NULL ? cacheDir : "");
+            if (cacheDir != NULL) pEnv->ReleaseStringUTFChars(pCacheDir, cacheDir);
         } else {
             Engine::engineErr.add(helper::NNUE_FILE_OPEN_ERROR);
         }
 
+        // Close the file assets, the readers open their own
+        if (nnueAssetBig != NULL) AAsset_close(nnueAssetBig);
+        if (nnueAssetSmall != NULL) AAsset_close(nnueAssetSmall);
+
     }
 
     // Keep track of the engine object
@@ -82,6 +117,15 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_initialise (
     MainBoardMap.insert(std::pair<int, BitBoard*>(id, new BitBoard()));
     SearchBoardMap.insert(std::pair<int, BitBoard*>(id, new BitBoard()));
 
+    // Create the engine context of the activity, unless the networks could not be loaded
+    if (Engine::sharedNetworks) {
+        std::lock_guard<std::mutex> lock(ContextMutex);
+        if (ContextMap.find(pActivityID) == ContextMap.end()) {
+            ContextMap.insert(std::pair<int, Engine::Context*>(pActivityID, new Engine::Context()));
+        }
+        ActivityMap[id] = pActivityID;
+    }
+
 }
 
 /// <summary>
@@ -296,6 +340,42 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_setStateArray (
     }
 }
 
+/// <summary>
+/// Makes the move which leads to the next board and state, adding it to the move history
+/// used for repetition detection
+/// </summary>
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_replayMoveL (
+        JNIEnv* pEnv,
+        jobject pThis,
+        jlongArray pNextBoardArray,
+        jintArray pNextStateArray,
+        jint pId)
+{
+    auto boardItr = MainBoardMap.find(pId);
+    if(boardItr != MainBoardMap.end()) {
+
+        jlong jboardArray[276] = {0};
+        pEnv->GetLongArrayRegion(pNextBoardArray, 0, 276, jboardArray);
+        jint jstateArray[8] = {0};
+        pEnv->GetIntArrayRegion(pNextStateArray, 0, 8, jstateArray);
+
+        uint64_t boardArray[276];
+        for (int i = 0; i < 276; ++i) boardArray[i] = (uint64_t) jboardArray[i];
+        int32_t stateArray[8];
+        for (int i = 0; i < 8; ++i) stateArray[i] = (int32_t) jstateArray[i];
+
+        BitBoard nextBoard;
+        nextBoard.SetBoardArray(boardArray);
+        nextBoard.SetStateArray(stateArray);
+
+        return MoveRules::ReplayMove(*boardItr->second, nextBoard) ? JNI_TRUE : JNI_FALSE;
+    }
+
+    return JNI_FALSE;
+}
+
 /// <summary>
 /// Set white clock offset
 /// </summary>
@@ -384,10 +464,13 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_reset (
     }
 
     auto searchItr = SearchBoardMap.find(pId);
+    Engine::Context* context = findContext(pId);
     if(searchItr != SearchBoardMap.end()) {
        searchItr->second->Reset();
-       Search::Cancel();
-       Search::ClearCache();
+       if (context != nullptr) {
+           Search::Cancel(*context);
+           Search::ClearCache(*context);
+       }
     }
 
 
@@ -400,9 +483,13 @@ extern "C"
 JNIEXPORT void JNICALL
 Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_cancelSearch (
         JNIEnv* pEnv,
-        jobject pThis)
+        jobject pThis,
+        jint pId)
 {
-    Search::Cancel();
+    Engine::Context* context = findContext(pId);
+    if (context != nullptr) {
+        Search::Cancel(*context);
+    }
 }
 
 /// <summary>
@@ -480,6 +567,25 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_getStateGameStatus
     }
 }
 
+/// <summary>
+///  Get game status, including the draw rules, for the side to move
+/// </summary>
+extern "C"
+JNIEXPORT jint JNICALL
+Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_getGameStatus (
+        JNIEnv* pEnv,
+        jobject pThis,
+        jint pId)
+{
+    auto boardItr = MainBoardMap.find(pId);
+    if(boardItr != MainBoardMap.end()) {
+        return (int)MoveRules::GetGameStatus(*boardItr->second);
+    }
+    else {
+        return 0;
+    }
+}
+
 /// <summary>
 ///  Set state game status
 /// </summary>
@@ -604,6 +710,26 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_getPotentialMoveL
     }
 }
 
+/// <summary>
+///  Gets the legal moves of a given square index
+/// </summary>
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_getLegalMoveL (
+        JNIEnv* pEnv,
+        jobject pThis,
+        jint pSqIndex,
+        jint pId)
+{
+    auto boardItr = MainBoardMap.find(pId);
+    if(boardItr != MainBoardMap.end()) {
+        return MoveRules::GetLegalMove(*boardItr->second, pSqIndex);
+    }
+    else {
+        return 0;
+    }
+}
+
 /// <summary>
 ///  Moves a piece
 /// </summary>
@@ -651,7 +777,9 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_move (
         jstring jMoveDataStr = pEnv->NewStringUTF(moveDataStr.c_str());
         pEnv->SetObjectField(mResultObj, moveDataStrFieldID, jMoveDataStr);
 
-        jstring jMoveSAN = pEnv->NewStringUTF(boardItr->second->MoveSAN.c_str());
+        char moveSAN[MoveRules::MAX_SAN_LENGTH] = "";
+        if (success && pCommit) MoveRules::GetMoveSAN(*boardItr->second, moveSAN);
+        jstring jMoveSAN = pEnv->NewStringUTF(moveSAN);
         pEnv->SetObjectField(mResultObj, moveSANFieldID, jMoveSAN);
 
         return mResultObj;
@@ -858,6 +986,36 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_getFENCharFromSpin
 
 }
 
+/// <summary>
+///  Reads the search options from the Kotlin object
+/// </summary>
+Search::SearchOptions getSearchOptions(JNIEnv* pEnv, jobject pSearchOptions)
+{
+    Search::SearchOptions options;
+
+    jclass mSearchOptions = pEnv->GetObjectClass(pSearchOptions);
+
+    jfieldID limitSkillLevelFieldID = pEnv->GetFieldID(mSearchOptions, "limitSkillLevel","I");
+    options.limitSkillLevel = pEnv->GetIntField(pSearchOptions, limitSkillLevelFieldID);
+
+    jfieldID limitDepthFieldID = pEnv->GetFieldID(mSearchOptions, "limitDepth","I");
+    options.limitDepth = pEnv->GetIntField(pSearchOptions, limitDepthFieldID);
+
+    jfieldID limitNodesFieldID = pEnv->GetFieldID(mSearchOptions, "limitNodes","I");
+    options.limitNodes = pEnv->GetIntField(pSearchOptions, limitNodesFieldID);
+
+    jfieldID limitMoveDurationFieldID = pEnv->GetFieldID(mSearchOptions, "limitMoveDuration","I");
+    options.limitMoveDuration = pEnv->GetIntField(pSearchOptions, limitMoveDurationFieldID);
+
+    jfieldID limitThreadsFieldID = pEnv->GetFieldID(mSearchOptions, "limitThreads","I");
+    options.limitThreads = pEnv->GetIntField(pSearchOptions, limitThreadsFieldID);
+
+    jfieldID randomiseFirstMoveFieldID = pEnv->GetFieldID(mSearchOptions, "randomiseFirstMove","Z");
+    options.randomiseFirstMove = pEnv->GetBooleanField(pSearchOptions, randomiseFirstMoveFieldID);
+
+    return options;
+}
+
 /// <summary>
 ///  Searches for the best move
 /// </summary>
@@ -870,47 +1028,24 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_searchStart (
         jint pId) {
     auto boardItr = MainBoardMap.find(pId);
     auto searchItr = SearchBoardMap.find(pId);
+    Engine::Context* context = findContext(pId);
     if (boardItr != MainBoardMap.end() && searchItr != SearchBoardMap.end()) {
 
-        uint64_t boardArray[276];
-        int32_t stateArray[8];
-
-
-        boardItr->second->GetBoardArray(boardArray);
-        boardItr->second->GetStateArray(stateArray);
-        searchItr->second->SetBoardArray(boardArray);
-        searchItr->second->SetStateArray(stateArray);
+        // Copy the board with its move history so the engine can see repetitions
+        boardItr->second->Copy(*searchItr->second);
 
 
         Search::SearchTreeNode bestMove;
         Search::SearchStatistics statistics;
-        Search::SearchOptions options;
-
-        jclass mSearchOptions = pEnv->GetObjectClass(pSearchOptions);
-
-        jfieldID limitSkillLevelFieldID = pEnv->GetFieldID(mSearchOptions, "limitSkillLevel","I");
-        options.limitSkillLevel = pEnv->GetIntField(pSearchOptions, limitSkillLevelFieldID);
-
-        jfieldID limitDepthFieldID = pEnv->GetFieldID(mSearchOptions, "limitDepth","I");
-        options.limitDepth = pEnv->GetIntField(pSearchOptions, limitDepthFieldID);
-
-        jfieldID limitNodesFieldID = pEnv->GetFieldID(mSearchOptions, "limitNodes","I");
-        options.limitNodes = pEnv->GetIntField(pSearchOptions, limitNodesFieldID);
-
-        jfieldID limitMoveDurationFieldID = pEnv->GetFieldID(mSearchOptions, "limitMoveDuration","I");
-        options.limitMoveDuration = pEnv->GetIntField(pSearchOptions, limitMoveDurationFieldID);
+        Search::SearchOptions options = getSearchOptions(pEnv, pSearchOptions);
 
-        jfieldID limitThreadsFieldID = pEnv->GetFieldID(mSearchOptions, "limitThreads","I");
-        options.limitThreads = pEnv->GetIntField(pSearchOptions, limitThreadsFieldID);
-
-        jfieldID randomiseFirstMoveFieldID = pEnv->GetFieldID(mSearchOptions, "randomiseFirstMove","Z");
-        options.randomiseFirstMove = pEnv->GetBooleanField(pSearchOptions, randomiseFirstMoveFieldID);
-
-        jfieldID alternateMoveFieldID = pEnv->GetFieldID(mSearchOptions, "alternateMove","Z");
-        options.alternateMove = pEnv->GetBooleanField(pSearchOptions, alternateMoveFieldID);
-
-        // Search for a move
-        Search::GetBestMove(*searchItr->second, options, bestMove, statistics);
+        // Search for a move, there is no engine context if the networks could not be loaded
+        if (context != nullptr) {
+            Search::GetBestMove(*context, *searchItr->second, options, bestMove, statistics);
+        }
+        else {
+            bestMove.error = Engine::engineErr.first();
+        }
 
         // Copy the values to result
         jclass mResultClass = pEnv->FindClass("purpletreesoftware/karuahchess/engine/SearchResult");
@@ -944,6 +1079,47 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_searchStart (
 
 }
 
+/// <summary>
+///  Searches the reply expected to the last engine move while the user is thinking. The next search
+///  continues from it if the user plays that reply.
+/// </summary>
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_ponderStart (
+        JNIEnv* pEnv,
+        jobject pThis,
+        jobject pSearchOptions,
+        jint pId) {
+    auto boardItr = MainBoardMap.find(pId);
+    Engine::Context* context = findContext(pId);
+    if (boardItr != MainBoardMap.end() && context != nullptr) {
+        Search::SearchOptions options = getSearchOptions(pEnv, pSearchOptions);
+        return Search::SearchSession::Ponder(*context, *boardItr->second, options) != nullptr ? JNI_TRUE : JNI_FALSE;
+    }
+
+    return JNI_FALSE;
+}
+
+/// <summary>
+///  Searches the engine replies to the moves the user is most likely to play, used when there
+///  is no expected reply to ponder on. A later search of one of those positions is answered
+///  from the result cache.
+/// </summary>
+extern "C"
+JNIEXPORT void JNICALL
+Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_speculateStart (
+        JNIEnv* pEnv,
+        jobject pThis,
+        jobject pSearchOptions,
+        jint pId) {
+    auto boardItr = MainBoardMap.find(pId);
+    Engine::Context* context = findContext(pId);
+    if (boardItr != MainBoardMap.end() && context != nullptr) {
+        Search::SearchOptions options = getSearchOptions(pEnv, pSearchOptions);
+        Search::SearchSession::Speculate(*context, *boardItr->second, options);
+    }
+}
+
 
 
 /// <summary>
@@ -1002,4 +1178,8 @@ Java_purpletreesoftware_karuahchess_engine_KaruahChessEngineC_cleanup (
         SearchBoardMap.erase(searchItr);
     }
 
+    // The engine context is kept for the next engine object of the activity
+    std::lock_guard<std::mutex> lock(ContextMutex);
+    ActivityMap.erase(pId);
+
 }
\ No newline at end of file
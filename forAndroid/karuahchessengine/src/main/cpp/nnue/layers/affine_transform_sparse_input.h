@@ -35,7 +35,7 @@
   This file contains the definition for a fully connected layer (aka affine transform) with block sparse input.
 */
 
-namespace Stockfish::Eval::NNUE::Layers {
+namespace Stockfish::Eval::NNUE::inline NNUE_ISA::Layers {
 
 #if (USE_SSSE3 | (USE_NEON >= 8))
 alignas(CacheLineSize) static inline const
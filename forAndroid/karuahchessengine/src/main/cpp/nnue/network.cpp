@@ -18,9 +18,11 @@
 
 #include "network.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <optional>
 #include <type_traits>
 #include <vector>
@@ -32,6 +34,7 @@
 #include "../sf_types.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
+#include "nnue_dispatch.h"
 #include "nnue_misc.h"
 
 #include "../engine.h"
@@ -45,94 +48,94 @@ namespace Detail {
 
 // Read evaluation function parameters
 template<typename T>
-bool read_parameters(std::istream& stream, T& reference) {
+bool read_parameters(std::istream& stream, T& reference, bool (*read)(void*, std::istream&)) {
 
     std::uint32_t header;
     header = read_little_endian<std::uint32_t>(stream);
     if (!stream || header != T::get_hash_value())
         return false;
-    return reference.read_parameters(stream);
+    return read(&reference, stream);
 }
 
 // Write evaluation function parameters
 template<typename T>
-bool write_parameters(std::ostream& stream, const T& reference) {
+bool write_parameters(std::ostream& stream,
+                      const T&      reference,
+                      bool (*write)(const void*, std::ostream&)) {
 
     write_little_endian<std::uint32_t>(stream, T::get_hash_value());
-    return reference.write_parameters(stream);
+    return write(&reference, stream);
 }
 
 }  // namespace Detail
 
 template<typename Arch, typename Transformer>
-Network<Arch, Transformer>::Network(const Network<Arch, Transformer>& other) :
-    evalFile(other.evalFile),
-    embeddedType(other.embeddedType) {
+int Network<Arch, Transformer>::load(const KaruahChess::Engine::NNUEFile& file,
+                                     const std::string&                   cacheDir) {
+
+    /// Karuah Chess patch for loading NNUE files. The network is mapped from the
+    /// weight blob in the cache directory if there is one. Otherwise the file is
+    /// read, converted and written to the cache so later starts can map it.
+    /// Returns 0, or the error number with the network zeroed if the file could
+    /// not be loaded. The engine state is left to the caller, as the big network
+    /// is loaded on a background thread.
+    const BlobKey key = blob_key(file.name, std::uint64_t(std::max(file.size, 0L)));
+    if (use_blob(WeightBlob::open(cacheDir, key)))
+        return 0;
+
+    // The file contents are only needed for the conversion
+    std::vector<char> buffer;
+    try {
+        buffer.resize(std::size_t(std::max(file.size, 0L)));
+    }
+    catch (const std::bad_alloc&) {
+        initialize();
+        return KaruahChess::helper::NNUE_MEMORY_ALLOCATION_ERROR;
+    }
 
-    if (other.featureTransformer)
-        featureTransformer = make_unique_large_page<Transformer>(*other.featureTransformer);
+    std::optional<std::string> description;
+    if (!buffer.empty() && file.read && file.read(buffer.data(), file.size)) {
+        KaruahChess::Engine::membuf nnueMemoryBuffer(buffer.data(), buffer.data() + buffer.size());
+        std::istream nnueStream(&nnueMemoryBuffer);
+        description = load(nnueStream);
+    }
+    else
+    {
+        initialize();
+    }
 
-    network = make_unique_aligned<Arch[]>(LayerStacks);
+    if (!description.has_value())
+        return KaruahChess::helper::NNUE_ERROR;
 
-    if (!other.network)
-        return;
+    if (WeightBlob::write(cacheDir, key, featureTransformer.get(), network.get()))
+        use_blob(WeightBlob::open(cacheDir, key));
 
-    for (std::size_t i = 0; i < LayerStacks; ++i)
-        network[i] = other.network[i];
+    return 0;
 }
 
-template<typename Arch, typename Transformer>
-Network<Arch, Transformer>&
-Network<Arch, Transformer>::operator=(const Network<Arch, Transformer>& other) {
-    evalFile     = other.evalFile;
-    embeddedType = other.embeddedType;
-
-    if (other.featureTransformer)
-        featureTransformer = make_unique_large_page<Transformer>(*other.featureTransformer);
-
-    network = make_unique_aligned<Arch[]>(LayerStacks);
 
-    if (!other.network)
-        return *this;
-
-    for (std::size_t i = 0; i < LayerStacks; ++i)
-        network[i] = other.network[i];
+template<typename Arch, typename Transformer>
+BlobKey Network<Arch, Transformer>::blob_key(const std::string& sourceName,
+                                             std::uint64_t      sourceSize) const {
+    static_assert(std::is_trivially_copyable_v<Transformer> && std::is_trivially_copyable_v<Arch>,
+                  "The parameters are stored as raw images");
 
-    return *this;
+    return {sourceName, sourceSize, Network::hash, sizeof(Transformer), sizeof(Arch), LayerStacks};
 }
 
+
+// Karuah Chess - uses the parameters of a mapped weight blob in place of the
+// allocated ones, returns false if there is no blob. The blob stays mapped
+// while any copy of the network uses it.
 template<typename Arch, typename Transformer>
-void Network<Arch, Transformer>::load() {
-    
-    /// Karuah Chess patch for loading NNUE files.
-    if (std::is_same_v<Arch, BigNetworkArchitecture> && !KaruahChess::Engine::nnueLoadedBig) {
-        KaruahChess::Engine::membuf nnueMemoryBuffer(KaruahChess::Engine::nnueFileBufferBig, KaruahChess::Engine::nnueFileBufferBig + KaruahChess::Engine::nnueFileBufferSizeBig);
-        std::istream nnueStream(&nnueMemoryBuffer);
-        auto description = load(nnueStream);
-        if (description.has_value()) {
-            KaruahChess::Engine::nnueLoadedBig = true;
-        }
-        else
-        {
-            KaruahChess::Engine::engineErr.add(KaruahChess::helper::NNUE_ERROR);
-        }
-    }
-    
-    
-    if (std::is_same_v<Arch, SmallNetworkArchitecture> && !KaruahChess::Engine::nnueLoadedSmall) {
-        KaruahChess::Engine::membuf nnueMemoryBuffer(KaruahChess::Engine::nnueFileBufferSmall, KaruahChess::Engine::nnueFileBufferSmall + KaruahChess::Engine::nnueFileBufferSizeSmall);
-        std::istream nnueStream(&nnueMemoryBuffer);
-        auto description = load(nnueStream);
-        if (description.has_value()) {
-            KaruahChess::Engine::nnueLoadedSmall = true;
-        }
-        else
-        {
-            KaruahChess::Engine::engineErr.add(KaruahChess::helper::NNUE_ERROR);
-        }
-    }
-    
+bool Network<Arch, Transformer>::use_blob(std::shared_ptr<const WeightBlob> mapped) {
+    if (!mapped)
+        return false;
 
+    featureTransformer = std::shared_ptr<const Transformer>(
+      mapped, static_cast<const Transformer*>(mapped->transformer()));
+    network = std::shared_ptr<const Arch[]>(mapped, static_cast<const Arch*>(mapped->layers()));
+    return true;
 }
 
 
@@ -140,38 +143,20 @@ template<typename Arch, typename Transformer>
 NetworkOutput
 Network<Arch, Transformer>::evaluate(const Position&                         pos,
                                      AccumulatorCaches::Cache<FTDimensions>* cache) const {
-    // We manually align the arrays on the stack because with gcc < 9.3
-    // overaligning stack variables with alignas() doesn't work correctly.
-
-    constexpr uint64_t alignment = CacheLineSize;
-
-#if defined(ALIGNAS_ON_STACK_VARIABLES_BROKEN)
-    TransformedFeatureType
-      transformedFeaturesUnaligned[FeatureTransformer<FTDimensions, nullptr>::BufferSize
-                                   + alignment / sizeof(TransformedFeatureType)];
-
-    auto* transformedFeatures = align_ptr_up<alignment>(&transformedFeaturesUnaligned[0]);
-#else
-    alignas(alignment) TransformedFeatureType
-      transformedFeatures[FeatureTransformer<FTDimensions, nullptr>::BufferSize];
-#endif
-
-    ASSERT_ALIGNED(transformedFeatures, alignment);
-
-    const int  bucket     = (pos.count<ALL_PIECES>() - 1) / 4;
-    const auto psqt       = featureTransformer->transform(pos, cache, transformedFeatures, bucket);
-    const auto positional = network[bucket].propagate(transformedFeatures);
+    // Karuah Chess - the transform and propagation run in the kernels selected
+    // for the processor, see nnue_dispatch.h
+    const int  bucket = (pos.count<ALL_PIECES>() - 1) / 4;
+    const auto [psqt, positional] = network_kernels<FTDimensions>().evaluate(
+      transformer(), &layers()[bucket], pos, cache, bucket);
     return {static_cast<Value>(psqt / OutputScale), static_cast<Value>(positional / OutputScale)};
 }
 
 
 template<typename Arch, typename Transformer>
 void Network<Arch, Transformer>::verify() const {
-    // Karuah Chess patch for verify    
-
-    if (KaruahChess::Engine::engineErr.exists(KaruahChess::helper::NNUE_ERROR) ||
-        KaruahChess::Engine::engineErr.exists(KaruahChess::helper::NNUE_FILE_OPEN_ERROR) ||
-        KaruahChess::Engine::engineErr.exists(KaruahChess::helper::NNUE_MEMORY_ALLOCATION_ERROR))
+    // Karuah Chess patch for verify. The load error is in the engine errors, a
+    // network that failed to load is left unloaded.
+    if (!is_loaded())
     {
         // This should never happen
         throw std::runtime_error("NNUE file is not loaded.");
@@ -182,37 +167,19 @@ void Network<Arch, Transformer>::verify() const {
 template<typename Arch, typename Transformer>
 void Network<Arch, Transformer>::hint_common_access(
   const Position& pos, AccumulatorCaches::Cache<FTDimensions>* cache) const {
-    featureTransformer->hint_common_access(pos, cache);
+    network_kernels<FTDimensions>().hint_common_access(transformer(), pos, cache);
 }
 
 template<typename Arch, typename Transformer>
 NnueEvalTrace
 Network<Arch, Transformer>::trace_evaluate(const Position&                         pos,
                                            AccumulatorCaches::Cache<FTDimensions>* cache) const {
-    // We manually align the arrays on the stack because with gcc < 9.3
-    // overaligning stack variables with alignas() doesn't work correctly.
-    constexpr uint64_t alignment = CacheLineSize;
-
-#if defined(ALIGNAS_ON_STACK_VARIABLES_BROKEN)
-    TransformedFeatureType
-      transformedFeaturesUnaligned[FeatureTransformer<FTDimensions, nullptr>::BufferSize
-                                   + alignment / sizeof(TransformedFeatureType)];
-
-    auto* transformedFeatures = align_ptr_up<alignment>(&transformedFeaturesUnaligned[0]);
-#else
-    alignas(alignment) TransformedFeatureType
-      transformedFeatures[FeatureTransformer<FTDimensions, nullptr>::BufferSize];
-#endif
-
-    ASSERT_ALIGNED(transformedFeatures, alignment);
-
     NnueEvalTrace t{};
     t.correctBucket = (pos.count<ALL_PIECES>() - 1) / 4;
     for (IndexType bucket = 0; bucket < LayerStacks; ++bucket)
     {
-        const auto materialist =
-          featureTransformer->transform(pos, cache, transformedFeatures, bucket);
-        const auto positional = network[bucket].propagate(transformedFeatures);
+        const auto [materialist, positional] = network_kernels<FTDimensions>().evaluate(
+          transformer(), &layers()[bucket], pos, cache, bucket);
 
         t.psqt[bucket]       = static_cast<Value>(materialist / OutputScale);
         t.positional[bucket] = static_cast<Value>(positional / OutputScale);
@@ -231,10 +198,18 @@ void Network<Arch, Transformer>::initialize() {
 
 template<typename Arch, typename Transformer>
 std::optional<std::string> Network<Arch, Transformer>::load(std::istream& stream) {
-    initialize();
+    // Karuah Chess - the parameters are read in to new allocations, as the
+    // current ones may be shared with copies of the network
+    auto        newTransformer = make_unique_large_page<Transformer>();
+    auto        newNetwork     = make_unique_aligned<Arch[]>(LayerStacks);
     std::string description;
 
-    return read_parameters(stream, description) ? std::make_optional(description) : std::nullopt;
+    const bool success = read_parameters(stream, *newTransformer, newNetwork.get(), description);
+
+    featureTransformer = std::move(newTransformer);
+    network            = std::move(newNetwork);
+
+    return success ? std::make_optional(description) : std::nullopt;
 }
 
 
@@ -271,17 +246,20 @@ bool Network<Arch, Transformer>::write_header(std::ostream&      stream,
 
 template<typename Arch, typename Transformer>
 bool Network<Arch, Transformer>::read_parameters(std::istream& stream,
+                                                 Transformer&  transformerParameters,
+                                                 Arch*         layerParameters,
                                                  std::string&  netDescription) const {
     std::uint32_t hashValue;
     if (!read_header(stream, &hashValue, &netDescription))
         return false;
     if (hashValue != Network::hash)
         return false;
-    if (!Detail::read_parameters(stream, *featureTransformer))
+    const auto& kernels = network_kernels<FTDimensions>();
+    if (!Detail::read_parameters(stream, transformerParameters, kernels.read_transformer))
         return false;
     for (std::size_t i = 0; i < LayerStacks; ++i)
     {
-        if (!Detail::read_parameters(stream, network[i]))
+        if (!Detail::read_parameters(stream, layerParameters[i], kernels.read_layers))
             return false;
     }
     return stream && stream.peek() == std::ios::traits_type::eof();
@@ -293,11 +271,12 @@ bool Network<Arch, Transformer>::write_parameters(std::ostream&      stream,
                                                   const std::string& netDescription) const {
     if (!write_header(stream, Network::hash, netDescription))
         return false;
-    if (!Detail::write_parameters(stream, *featureTransformer))
+    const auto& kernels = network_kernels<FTDimensions>();
+    if (!Detail::write_parameters(stream, *featureTransformer, kernels.write_transformer))
         return false;
     for (std::size_t i = 0; i < LayerStacks; ++i)
     {
-        if (!Detail::write_parameters(stream, network[i]))
+        if (!Detail::write_parameters(stream, network[i], kernels.write_layers))
             return false;
     }
     return bool(stream);
@@ -313,4 +292,55 @@ template class Network<
   NetworkArchitecture<TransformedFeatureDimensionsSmall, L2Small, L3Small>,
   FeatureTransformer<TransformedFeatureDimensionsSmall, &StateInfo::accumulatorSmall>>;
 
+
+// Karuah Chess - shared networks
+
+SharedNetworks::SharedNetworks(const KaruahChess::Engine::NNUEFile& bigFile,
+                               const KaruahChess::Engine::NNUEFile& smallFile,
+                               const std::string&                   cacheDir) :
+    smallNetwork({EvalFileDefaultNameSmall, "None", ""}, EmbeddedNNUEType::SMALL),
+    bigNetwork({EvalFileDefaultNameBig, "None", ""}, EmbeddedNNUEType::BIG) {
+
+    if (int error = smallNetwork.load(smallFile, cacheDir); error != 0)
+    {
+        smallNetwork = NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, EmbeddedNNUEType::SMALL);
+        KaruahChess::Engine::engineErr.add(error);
+    }
+    else
+        KaruahChess::Engine::nnueLoadedSmall = true;
+
+    bigNetworkLoader = std::thread([this, bigFile, cacheDir]() {
+        if (int error = bigNetwork.load(bigFile, cacheDir); error != 0)
+        {
+            // A partly read network is not used, the engines carry on with the small network
+            bigNetwork = NetworkBig({EvalFileDefaultNameBig, "None", ""}, EmbeddedNNUEType::BIG);
+            KaruahChess::Engine::engineErr.add(error);
+        }
+        else
+            KaruahChess::Engine::nnueLoadedBig = true;
+
+        {
+            std::lock_guard<std::mutex> lock(bigNetworkMutex);
+            bigNetworkLoaded.store(true, std::memory_order_release);
+        }
+        bigNetworkCondition.notify_all();
+    });
+}
+
+// The big network cannot be abandoned part way through loading
+SharedNetworks::~SharedNetworks() {
+    if (bigNetworkLoader.joinable())
+        bigNetworkLoader.join();
+}
+
+const NetworkBig* SharedNetworks::big_if_loaded() const {
+    return bigNetworkLoaded.load(std::memory_order_acquire) ? &bigNetwork : nullptr;
+}
+
+const NetworkBig& SharedNetworks::wait_for_big() const {
+    std::unique_lock<std::mutex> lock(bigNetworkMutex);
+    bigNetworkCondition.wait(lock, [this] { return bigNetworkLoaded.load(); });
+    return bigNetwork;
+}
+
 }  // namespace Stockfish::Eval::NNUE
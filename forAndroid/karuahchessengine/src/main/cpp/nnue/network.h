@@ -19,18 +19,25 @@
 #ifndef NETWORK_H_INCLUDED
 #define NETWORK_H_INCLUDED
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 
+#include "../engine.h"
 #include "../sf_memory.h"
 #include "../sf_position.h"
 #include "../sf_types.h"
 #include "nnue_accumulator.h"
 #include "nnue_architecture.h"
+#include "nnue_blob.h"
 #include "nnue_feature_transformer.h"
 #include "nnue_misc.h"
 
@@ -54,14 +61,20 @@ class Network {
         evalFile(file),
         embeddedType(type) {}
 
-    Network(const Network& other);
-    Network(Network&& other) = default;
+    // Karuah Chess - the parameters are read only once loaded, so the copies of
+    // a network share them rather than each having their own
+    Network(const Network& other) = default;
+    Network(Network&& other)      = default;
 
-    Network& operator=(const Network& other);
-    Network& operator=(Network&& other) = default;
+    Network& operator=(const Network& other) = default;
+    Network& operator=(Network&& other)      = default;
+
+    // Karuah Chess - loads the network from the file, see network.cpp
+    int load(const KaruahChess::Engine::NNUEFile& file, const std::string& cacheDir);
+
+    // Karuah Chess - false until the network has been loaded
+    bool is_loaded() const { return transformer() != nullptr; }
 
-    void load();
-    
     NetworkOutput evaluate(const Position&                         pos,
                            AccumulatorCaches::Cache<FTDimensions>* cache) const;
 
@@ -83,14 +96,22 @@ class Network {
     bool read_header(std::istream&, std::uint32_t*, std::string*) const;
     bool write_header(std::ostream&, std::uint32_t, const std::string&) const;
 
-    bool read_parameters(std::istream&, std::string&) const;
+    bool read_parameters(std::istream&, Transformer&, Arch*, std::string&) const;
     bool write_parameters(std::ostream&, const std::string&) const;
 
+    // Karuah Chess - the parameters are either read in to allocations of the
+    // network or used in place from a mapped weight blob, see nnue_blob.h
+    BlobKey blob_key(const std::string& sourceName, std::uint64_t sourceSize) const;
+    bool    use_blob(std::shared_ptr<const WeightBlob> mapped);
+
+    const Transformer* transformer() const { return featureTransformer.get(); }
+    const Arch*        layers() const { return network.get(); }
+
     // Input feature converter
-    LargePagePtr<Transformer> featureTransformer;
+    std::shared_ptr<const Transformer> featureTransformer;
 
     // Evaluation function
-    AlignedPtr<Arch[]> network;
+    std::shared_ptr<const Arch[]> network;
 
     EvalFile         evalFile;
     EmbeddedNNUEType embeddedType;
@@ -126,6 +147,41 @@ struct Networks {
 };
 
 
+// Karuah Chess - the networks are loaded once and shared by every engine in the
+// process, each engine copies them in to its Networks without copying the
+// parameters. The small network is loaded by the constructor so that an engine
+// can search straight away, the big network is loaded on a background thread.
+// Load errors are added to the engine errors.
+class SharedNetworks {
+   public:
+    SharedNetworks(const KaruahChess::Engine::NNUEFile& bigFile,
+                   const KaruahChess::Engine::NNUEFile& smallFile,
+                   const std::string&                   cacheDir);
+    ~SharedNetworks();
+
+    SharedNetworks(const SharedNetworks&)            = delete;
+    SharedNetworks& operator=(const SharedNetworks&) = delete;
+
+    const NetworkSmall& small() const { return smallNetwork; }
+
+    // The big network, nullptr while it is loading. A network that failed to
+    // load is not loaded, see Network::is_loaded.
+    const NetworkBig* big_if_loaded() const;
+
+    // Blocking call to wait for the big network to load
+    const NetworkBig& wait_for_big() const;
+
+   private:
+    NetworkSmall smallNetwork;
+    NetworkBig   bigNetwork;
+
+    std::thread                     bigNetworkLoader;
+    std::atomic<bool>               bigNetworkLoaded{false};
+    mutable std::mutex              bigNetworkMutex;
+    mutable std::condition_variable bigNetworkCondition;
+};
+
+
 }  // namespace Stockfish
 
 #endif
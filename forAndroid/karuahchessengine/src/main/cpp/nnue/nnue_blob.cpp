@@ -0,0 +1,217 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "nnue_blob.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "nnue_dispatch.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define NNUE_BLOB_MMAP
+#endif
+
+namespace Stockfish::Eval::NNUE {
+
+namespace {
+
+constexpr char          BlobMagic[8] = {'K', 'C', 'N', 'N', 'B', 'L', 'O', 'B'};
+constexpr std::uint32_t BlobVersion  = 1;
+
+// The parameters start on a boundary that is a multiple of the page size of
+// all the supported systems, which is at most 16 KB on Android.
+constexpr std::uint64_t BlobAlignment = 16384;
+
+// The blob is read on the machine that wrote it, so the header is in the byte
+// order of the machine. Every field is derived from the key, so a blob matches
+// when its header is identical to the one made for the key.
+struct BlobHeader {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t hash;
+    char          kernels[32];
+    char          sourceName[128];
+    std::uint64_t sourceSize;
+    std::uint64_t transformerSize;
+    std::uint64_t layersSize;
+    std::uint64_t layerStacks;
+    std::uint64_t transformerOffset;
+    std::uint64_t layersOffset;
+    std::uint64_t length;
+};
+
+static_assert(sizeof(BlobHeader) == 232, "BlobHeader must not have padding");
+static_assert(sizeof(BlobHeader) <= BlobAlignment);
+
+constexpr std::uint64_t align_blob(std::uint64_t n) {
+    return (n + BlobAlignment - 1) / BlobAlignment * BlobAlignment;
+}
+
+std::string source_file_name(const BlobKey& key) {
+    return std::filesystem::path(key.sourceName).filename().string();
+}
+
+BlobHeader make_header(const BlobKey& key) {
+    BlobHeader header{};
+
+    std::memcpy(header.magic, BlobMagic, sizeof(BlobMagic));
+    header.version = BlobVersion;
+    header.hash    = key.hash;
+    std::strncpy(header.kernels, kernels().name, sizeof(header.kernels) - 1);
+    std::strncpy(header.sourceName, source_file_name(key).c_str(), sizeof(header.sourceName) - 1);
+    header.sourceSize        = key.sourceSize;
+    header.transformerSize   = key.transformerSize;
+    header.layersSize        = key.layersSize;
+    header.layerStacks       = key.layerStacks;
+    header.transformerOffset = BlobAlignment;
+    header.layersOffset      = align_blob(header.transformerOffset + key.transformerSize);
+    header.length            = header.layersOffset + key.layersSize * key.layerStacks;
+
+    return header;
+}
+
+// One blob per network and kernels, so that a change of kernels, for example
+// for benchmarking, does not overwrite the blob of the kernels in normal use
+std::string blob_path(const std::string& directory, const BlobKey& key) {
+    return (std::filesystem::path(directory)
+            / (source_file_name(key) + "." + kernels().name + ".blob"))
+      .string();
+}
+
+}  // namespace
+
+
+WeightBlob::~WeightBlob() {
+#if defined(NNUE_BLOB_MMAP)
+    munmap(const_cast<char*>(address), length);
+#endif
+}
+
+
+std::shared_ptr<const WeightBlob> WeightBlob::open(const std::string& directory,
+                                                   const BlobKey&     key) {
+#if defined(NNUE_BLOB_MMAP)
+    if (directory.empty())
+        return nullptr;
+
+    const BlobHeader expected = make_header(key);
+    const std::string path     = blob_path(directory, key);
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    BlobHeader  header;
+    struct stat st;
+    bool        valid = pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header))
+                && std::memcmp(&header, &expected, sizeof(header)) == 0 && fstat(fd, &st) == 0
+                && std::uint64_t(st.st_size) == expected.length;
+
+    void* addr = valid ? mmap(nullptr, expected.length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+
+    if (addr == MAP_FAILED)
+        return nullptr;
+
+    // Start reading the parameters in the background, the mapping is used before
+    // the first search needs them
+    madvise(addr, expected.length, MADV_WILLNEED);
+
+    return std::shared_ptr<const WeightBlob>(new WeightBlob(static_cast<const char*>(addr),
+                                                            expected.length,
+                                                            expected.transformerOffset,
+                                                            expected.layersOffset));
+#else
+    (void) directory;
+    (void) key;
+    return nullptr;
+#endif
+}
+
+
+bool WeightBlob::write(const std::string& directory,
+                       const BlobKey&     key,
+                       const void*        transformer,
+                       const void*        layers) {
+#if defined(NNUE_BLOB_MMAP)
+    if (directory.empty())
+        return false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    const BlobHeader  header = make_header(key);
+    const std::string path   = blob_path(directory, key);
+
+    // Written under a unique name and renamed when complete, so that a blob that
+    // is found is never partly written, even with several processes converting
+    const std::string tempPath =
+      path + "." + std::to_string(getpid()) + "."
+      + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+
+    {
+        std::ofstream           file(tempPath, std::ios::binary | std::ios::trunc);
+        const std::vector<char> padding(BlobAlignment, 0);
+
+        auto pad_to = [&](std::uint64_t offset) {
+            file.write(padding.data(), std::streamsize(offset - std::uint64_t(file.tellp())));
+        };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad_to(header.transformerOffset);
+        file.write(static_cast<const char*>(transformer), std::streamsize(key.transformerSize));
+        pad_to(header.layersOffset);
+        file.write(static_cast<const char*>(layers),
+                   std::streamsize(key.layersSize * key.layerStacks));
+
+        if (!file || std::uint64_t(file.tellp()) != header.length)
+        {
+            file.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    return true;
+#else
+    (void) directory;
+    (void) key;
+    (void) transformer;
+    (void) layers;
+    return false;
+#endif
+}
+
+}  // namespace Stockfish::Eval::NNUE
@@ -0,0 +1,85 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Karuah Chess - cached weight blobs.
+//
+// Reading a .nnue file decompresses the parameters and puts the weights in the
+// order used by the selected kernels (see nnue_dispatch.h). A weight blob is the
+// result of that conversion written as raw images of the feature transformer and
+// the layer stacks, each starting on a page boundary. The blob is mapped read
+// only and the network uses the parameters in place, so once a network has been
+// converted later starts do not read the .nnue file at all, and the pages are
+// shared by the page cache instead of being a private copy of the process.
+
+#ifndef NNUE_BLOB_H_INCLUDED
+#define NNUE_BLOB_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Stockfish::Eval::NNUE {
+
+// Identifies the network a blob holds and the layout of its parameters
+struct BlobKey {
+    std::string   sourceName;  // file name of the .nnue the blob was converted from
+    std::uint64_t sourceSize;  // size of the .nnue file
+    std::uint32_t hash;        // hash of the network structure
+    std::size_t   transformerSize;
+    std::size_t   layersSize;  // size of one layer stack
+    std::size_t   layerStacks;
+};
+
+class WeightBlob {
+   public:
+    WeightBlob(const WeightBlob&)            = delete;
+    WeightBlob& operator=(const WeightBlob&) = delete;
+    ~WeightBlob();
+
+    // Maps the blob for the key from the directory. Returns nullptr if there is
+    // no blob, or it was written for another network, layout or set of kernels.
+    static std::shared_ptr<const WeightBlob> open(const std::string& directory,
+                                                  const BlobKey&     key);
+
+    // Writes the parameters as the blob for the key, replacing any previous one.
+    // The layer stacks are contiguous, as allocated by the network.
+    static bool write(const std::string& directory,
+                      const BlobKey&     key,
+                      const void*        transformer,
+                      const void*        layers);
+
+    const void* transformer() const { return address + transformerOffset; }
+    const void* layers() const { return address + layersOffset; }
+
+   private:
+    WeightBlob(const char* addr, std::size_t len, std::size_t ftOffset, std::size_t lsOffset) :
+        address(addr),
+        length(len),
+        transformerOffset(ftOffset),
+        layersOffset(lsOffset) {}
+
+    const char* address;
+    std::size_t length;
+    std::size_t transformerOffset;
+    std::size_t layersOffset;
+};
+
+}  // namespace Stockfish::Eval::NNUE
+
+#endif  // #ifndef NNUE_BLOB_H_INCLUDED
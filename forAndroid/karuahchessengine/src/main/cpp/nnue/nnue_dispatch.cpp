@@ -0,0 +1,140 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "nnue_dispatch.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__aarch64__) && defined(__linux__)
+    #include <sys/auxv.h>
+
+    #ifndef HWCAP_ASIMDDP
+        #define HWCAP_ASIMDDP (1 << 20)
+    #endif
+#endif
+
+namespace Stockfish::Eval::NNUE {
+
+// Defined by the nnue_kernels_*.cpp translation units
+extern const Kernels kernels_isa_default;
+#if defined(__x86_64__) || defined(_M_X64)
+extern const Kernels kernels_isa_avx2;
+extern const Kernels kernels_isa_avx512;
+extern const Kernels kernels_isa_vnni512;
+#elif defined(__aarch64__)
+extern const Kernels kernels_isa_neon_dotprod;
+#endif
+
+namespace {
+
+struct Candidate {
+    const Kernels* kernels;
+    bool (*supported)();
+};
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+
+bool has_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+bool has_avx512() {
+    return has_avx2() && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+bool has_vnni512() {
+    return has_avx512() && __builtin_cpu_supports("avx512vl")
+        && __builtin_cpu_supports("avx512vnni");
+}
+
+#elif defined(__aarch64__) && defined(__linux__)
+
+bool has_dotprod() {
+    return getauxval(AT_HWCAP) & HWCAP_ASIMDDP;
+}
+
+#endif
+
+bool always() { return true; }
+
+// Kernels in this binary, best first
+std::vector<Candidate> candidates() {
+    std::vector<Candidate> list;
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+    list.push_back({&kernels_isa_vnni512, has_vnni512});
+    list.push_back({&kernels_isa_avx512, has_avx512});
+    list.push_back({&kernels_isa_avx2, has_avx2});
+#elif defined(__aarch64__) && defined(__linux__)
+    list.push_back({&kernels_isa_neon_dotprod, has_dotprod});
+#endif
+
+    list.push_back({&kernels_isa_default, always});
+    return list;
+}
+
+// The networks are shared by all kernels, so the classes must have the same size
+bool compatible(const Kernels& k) {
+    const Kernels& d = kernels_isa_default;
+    return k.big.transformerSize == d.big.transformerSize
+        && k.big.layersSize == d.big.layersSize
+        && k.small.transformerSize == d.small.transformerSize
+        && k.small.layersSize == d.small.layersSize;
+}
+
+const Kernels* best_kernels() {
+    for (const Candidate& c : candidates())
+        if (c.supported() && compatible(*c.kernels))
+            return c.kernels;
+
+    return &kernels_isa_default;
+}
+
+const Kernels*& active_kernels() {
+    static const Kernels* active = best_kernels();
+    return active;
+}
+
+}  // namespace
+
+const Kernels& kernels() { return *active_kernels(); }
+
+std::vector<std::string> supported_kernels() {
+    std::vector<std::string> names;
+    for (const Candidate& c : candidates())
+        if (c.supported() && compatible(*c.kernels))
+            names.emplace_back(c.kernels->name);
+
+    return names;
+}
+
+bool select_kernels(std::string_view name) {
+    for (const Candidate& c : candidates())
+        if (name == c.kernels->name && c.supported() && compatible(*c.kernels))
+        {
+            active_kernels() = c.kernels;
+            return true;
+        }
+
+    return false;
+}
+
+}  // namespace Stockfish::Eval::NNUE
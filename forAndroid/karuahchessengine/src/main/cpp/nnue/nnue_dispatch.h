@@ -0,0 +1,105 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Karuah Chess - runtime selection of the NNUE inference kernels.
+//
+// The feature transformer and the layers are compiled once for each supported
+// instruction set (see nnue_kernels.h) and the best one the processor supports
+// is selected at startup. The parameter layout is the same for every
+// instruction set, as the arrays are padded to MaxSimdWidth, so the networks
+// are shared and only the order of the weights differs. That order is set by
+// the kernels when the network is read, which is why the kernels have to be
+// selected before the networks are loaded.
+
+#ifndef NNUE_DISPATCH_H_INCLUDED
+#define NNUE_DISPATCH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "nnue_accumulator.h"
+#include "nnue_architecture.h"
+
+namespace Stockfish {
+
+class Position;
+
+namespace Eval::NNUE {
+
+// Entry points for one network size. The transformer and layer stack are
+// passed untyped as each instruction set has its own copy of the classes.
+template<IndexType FTDimensions>
+struct NetworkKernels {
+    // Read or write the parameters, converting between the file order and the
+    // order used by the instruction set
+    bool (*read_transformer)(void* transformer, std::istream& stream);
+    bool (*read_layers)(void* layers, std::istream& stream);
+    bool (*write_transformer)(const void* transformer, std::ostream& stream);
+    bool (*write_layers)(const void* layers, std::ostream& stream);
+
+    // Returns the psqt and positional output of the layer stack for the bucket,
+    // before they are divided by OutputScale
+    std::pair<std::int32_t, std::int32_t> (*evaluate)(
+      const void*                             transformer,
+      const void*                             layers,
+      const Position&                         pos,
+      AccumulatorCaches::Cache<FTDimensions>* cache,
+      int                                     bucket);
+
+    void (*hint_common_access)(const void*                             transformer,
+                               const Position&                         pos,
+                               AccumulatorCaches::Cache<FTDimensions>* cache);
+
+    // Sizes of the classes, checked against the default kernels on selection
+    std::size_t transformerSize;
+    std::size_t layersSize;
+};
+
+struct Kernels {
+    const char*                                       name;
+    NetworkKernels<TransformedFeatureDimensionsBig>   big;
+    NetworkKernels<TransformedFeatureDimensionsSmall> small;
+};
+
+// Kernels in use, selected on first use
+const Kernels& kernels();
+
+template<IndexType FTDimensions>
+const NetworkKernels<FTDimensions>& network_kernels() {
+    if constexpr (FTDimensions == TransformedFeatureDimensionsBig)
+        return kernels().big;
+    else
+        return kernels().small;
+}
+
+// Names of the kernels in this binary the processor can run, best first
+std::vector<std::string> supported_kernels();
+
+// Selects kernels by name, for testing and benchmarking. Must be called before
+// the networks are loaded. Returns false if the kernels are not supported.
+bool select_kernels(std::string_view name);
+
+}  // namespace Eval::NNUE
+}  // namespace Stockfish
+
+#endif  // #ifndef NNUE_DISPATCH_H_INCLUDED
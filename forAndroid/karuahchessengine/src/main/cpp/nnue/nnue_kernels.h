@@ -0,0 +1,168 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Karuah Chess - NNUE kernels for one instruction set.
+//
+// This file is included once by each nnue_kernels_*.cpp translation unit. The
+// unit defines NNUE_ISA, the inline namespace for its copy of the NNUE classes,
+// and one of the NNUE_KERNELS_* levels below, and is compiled with the matching
+// instruction set flags. The default unit defines no level and uses the USE_*
+// flags of the build. Only the NNUE classes should be instantiated here, as any
+// other inline code could be shared with the rest of the engine by the linker.
+
+#ifndef NNUE_KERNELS_H_INCLUDED
+#define NNUE_KERNELS_H_INCLUDED
+
+#if defined(NNUE_KERNELS_AVX2) || defined(NNUE_KERNELS_AVX512) || defined(NNUE_KERNELS_VNNI512)
+    #undef USE_SSE2
+    #undef USE_SSSE3
+    #undef USE_SSE41
+    #undef USE_AVX2
+    #undef USE_AVX512
+    #undef USE_VNNI
+    #define USE_SSE2 1
+    #define USE_SSSE3 1
+    #define USE_SSE41 1
+    #define USE_AVX2 1
+    #if defined(NNUE_KERNELS_AVX512) || defined(NNUE_KERNELS_VNNI512)
+        #define USE_AVX512 1
+    #endif
+    #if defined(NNUE_KERNELS_VNNI512)
+        #define USE_VNNI 1
+    #endif
+#elif defined(NNUE_KERNELS_NEON_DOTPROD)
+    #undef USE_NEON
+    #undef USE_NEON_DOTPROD
+    #define USE_NEON 8
+    #define USE_NEON_DOTPROD 1
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "../sf_position.h"
+#include "../sf_types.h"
+#include "nnue_accumulator.h"
+#include "nnue_architecture.h"
+#include "nnue_common.h"
+#include "nnue_dispatch.h"
+#include "nnue_feature_transformer.h"
+
+#if defined(USE_VNNI) && defined(USE_AVX512)
+    #define NNUE_KERNELS_NAME "vnni512"
+#elif defined(USE_AVX512)
+    #define NNUE_KERNELS_NAME "avx512"
+#elif defined(USE_AVX2)
+    #define NNUE_KERNELS_NAME "avx2"
+#elif defined(USE_SSE41)
+    #define NNUE_KERNELS_NAME "sse41"
+#elif defined(USE_SSSE3)
+    #define NNUE_KERNELS_NAME "ssse3"
+#elif defined(USE_SSE2)
+    #define NNUE_KERNELS_NAME "sse2"
+#elif defined(USE_NEON_DOTPROD)
+    #define NNUE_KERNELS_NAME "neon_dotprod"
+#elif defined(USE_NEON)
+    #define NNUE_KERNELS_NAME "neon"
+#else
+    #define NNUE_KERNELS_NAME "generic"
+#endif
+
+#define NNUE_KERNELS_SYMBOL_(isa) kernels_##isa
+#define NNUE_KERNELS_SYMBOL(isa) NNUE_KERNELS_SYMBOL_(isa)
+
+namespace Stockfish::Eval::NNUE {
+
+namespace {
+
+template<typename Arch, typename Transformer>
+struct KernelsFor {
+    static constexpr IndexType FTDimensions = Arch::TransformedFeatureDimensions;
+
+    static bool read_transformer(void* transformer, std::istream& stream) {
+        return static_cast<Transformer*>(transformer)->read_parameters(stream);
+    }
+
+    static bool read_layers(void* layers, std::istream& stream) {
+        return static_cast<Arch*>(layers)->read_parameters(stream);
+    }
+
+    static bool write_transformer(const void* transformer, std::ostream& stream) {
+        return static_cast<const Transformer*>(transformer)->write_parameters(stream);
+    }
+
+    static bool write_layers(const void* layers, std::ostream& stream) {
+        return static_cast<const Arch*>(layers)->write_parameters(stream);
+    }
+
+    static std::pair<std::int32_t, std::int32_t>
+    evaluate(const void*                             transformer,
+             const void*                             layers,
+             const Position&                         pos,
+             AccumulatorCaches::Cache<FTDimensions>* cache,
+             int                                     bucket) {
+        // We manually align the arrays on the stack because with gcc < 9.3
+        // overaligning stack variables with alignas() doesn't work correctly.
+        constexpr uint64_t alignment = CacheLineSize;
+
+#if defined(ALIGNAS_ON_STACK_VARIABLES_BROKEN)
+        TransformedFeatureType
+          transformedFeaturesUnaligned[Transformer::BufferSize
+                                       + alignment / sizeof(TransformedFeatureType)];
+
+        auto* transformedFeatures = align_ptr_up<alignment>(&transformedFeaturesUnaligned[0]);
+#else
+        alignas(alignment) TransformedFeatureType transformedFeatures[Transformer::BufferSize];
+#endif
+
+        ASSERT_ALIGNED(transformedFeatures, alignment);
+
+        const auto psqt = static_cast<const Transformer*>(transformer)
+                            ->transform(pos, cache, transformedFeatures, bucket);
+        const auto positional = static_cast<const Arch*>(layers)->propagate(transformedFeatures);
+        return {psqt, positional};
+    }
+
+    static void hint_common_access(const void*                             transformer,
+                                   const Position&                         pos,
+                                   AccumulatorCaches::Cache<FTDimensions>* cache) {
+        static_cast<const Transformer*>(transformer)->hint_common_access(pos, cache);
+    }
+
+    static constexpr NetworkKernels<FTDimensions> table = {
+      read_transformer, read_layers,         write_transformer,   write_layers,
+      evaluate,         hint_common_access, sizeof(Transformer), sizeof(Arch)};
+};
+
+}  // namespace
+
+extern const Kernels NNUE_KERNELS_SYMBOL(NNUE_ISA);
+
+const Kernels NNUE_KERNELS_SYMBOL(NNUE_ISA) = {
+  NNUE_KERNELS_NAME,
+  KernelsFor<NetworkArchitecture<TransformedFeatureDimensionsBig, L2Big, L3Big>,
+             FeatureTransformer<TransformedFeatureDimensionsBig, &StateInfo::accumulatorBig>>::table,
+  KernelsFor<NetworkArchitecture<TransformedFeatureDimensionsSmall, L2Small, L3Small>,
+             FeatureTransformer<TransformedFeatureDimensionsSmall,
+                                &StateInfo::accumulatorSmall>>::table};
+
+}  // namespace Stockfish::Eval::NNUE
+
+#endif  // #ifndef NNUE_KERNELS_H_INCLUDED
@@ -0,0 +1,29 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2024 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Karuah Chess - NNUE kernels for ARMv8.2 processors with the dot product instructions.
+// Compiled with -march=armv8.2-a+dotprod.
+
+#if defined(__aarch64__)
+
+    #define NNUE_ISA isa_neon_dotprod
+    #define NNUE_KERNELS_NEON_DOTPROD
+
+    #include "nnue_kernels.h"
+
+#endif
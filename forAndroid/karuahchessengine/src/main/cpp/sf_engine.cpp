@@ -46,7 +46,10 @@ namespace NN = Eval::NNUE;
 constexpr auto StartFEN  = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 constexpr int  MaxHashMB = Is64Bit ? 33554432 : 2048;
 
-Engine::Engine() :    
+// Karuah Chess - the networks are copies of the shared networks, the copies share
+// the parameters. The engine can search straight away with the small network, the
+// big network is swapped in between searches once it has loaded.
+Engine::Engine(std::shared_ptr<const NN::SharedNetworks> sharedNetworks_) :
     numaContext(NumaConfig::from_system()),
     states(new std::deque<StateInfo>(1)),
     threads(),
@@ -54,7 +57,8 @@ Engine::Engine() :
       numaContext,
       NN::Networks(
         NN::NetworkBig({EvalFileDefaultNameBig, "None", ""}, NN::EmbeddedNNUEType::BIG),
-        NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, NN::EmbeddedNNUEType::SMALL))) {
+        NN::NetworkSmall(sharedNetworks_->small()))),
+    sharedNetworks(std::move(sharedNetworks_)) {
     pos.set(StartFEN, false, &states->back());
     capSq = SQ_NONE;
     
@@ -96,13 +100,17 @@ Engine::Engine() :
     options["Syzygy50MoveRule"] << Option(true);
     options["SyzygyProbeLimit"] << Option(7, 0, 7);
     
-    load_networks();
     resize_threads();
 }
 
+Engine::~Engine() { wait_for_search_finished(); }
+
 
 void Engine::go(Search::LimitsType& limits) {
     assert(limits.perft == 0);
+
+    // Karuah Chess - use the big network from this search on if it has loaded
+    swap_in_big_network(false);
     verify_networks();
     limits.capSq = capSq;
 
@@ -110,6 +118,29 @@ void Engine::go(Search::LimitsType& limits) {
 }
 void Engine::stop() { threads.stop = true; }
 
+uint64_t Engine::perft(const std::string&                       fen,
+                       Depth                                    depth,
+                       size_t                                   hashMB,
+                       std::vector<Benchmark::PerftDivideItem>& divide) {
+    wait_for_search_finished();
+
+    std::unique_ptr<Benchmark::PerftHash> hash;
+    if (hashMB > 0)
+        hash = std::make_unique<Benchmark::PerftHash>(hashMB);
+
+    return Benchmark::perft(threads, fen, depth, options["UCI_Chess960"], hash.get(), divide);
+}
+
+void Engine::run_on_threads(const std::function<void(size_t)>& job) {
+    wait_for_search_finished();
+
+    for (size_t i = 0; i < threads.num_threads(); ++i)
+        threads.run_on_thread(i, [&job, i]() { job(i); });
+
+    for (size_t i = 0; i < threads.num_threads(); ++i)
+        threads.wait_on_thread(i);
+}
+
 void Engine::search_clear() {
     wait_for_search_finished();
 
@@ -135,13 +166,36 @@ void Engine::set_on_bestmove(std::function<void(std::string_view, std::string_vi
     updateContext.onBestmove = std::move(f);
 }
 
+// Karuah Chess - search information as records
+void Engine::set_info_queue(std::shared_ptr<Search::InfoQueue> queue) {
+    updateContext.infoQueue = std::move(queue);
+}
+
 void Engine::wait_for_search_finished() { threads.main_thread()->wait_for_search_finished(); }
 
 void Engine::set_position(const std::string& fen, const std::vector<std::string>& moves) {
     // Drop the old state and create a new one
     states = StateListPtr(new std::deque<StateInfo>(1));
     pos.set(fen, options["UCI_Chess960"], &states->back());
+    apply_moves(moves);
+}
+
+void Engine::set_position(const PositionSetup& setup, const std::vector<Move>& moves) {
+    // Drop the old state and create a new one
+    states = StateListPtr(new std::deque<StateInfo>(1));
+    pos.set(setup, &states->back());
+
+    capSq = SQ_NONE;
+    for (const auto& m : moves)
+    {
+        if (!pos.pseudo_legal(m) || !pos.legal(m))
+            break;
+
+        apply_move(m);
+    }
+}
 
+void Engine::apply_moves(const std::vector<std::string>& moves) {
     capSq = SQ_NONE;
     for (const auto& move : moves)
     {
@@ -150,16 +204,20 @@ void Engine::set_position(const std::string& fen, const std::vector<std::string>
         if (m == Move::none())
             break;
 
-        states->emplace_back();
-        pos.do_move(m, states->back());
-
-        capSq          = SQ_NONE;
-        DirtyPiece& dp = states->back().dirtyPiece;
-        if (dp.dirty_num > 1 && dp.to[1] == SQ_NONE)
-            capSq = m.to_sq();
+        apply_move(m);
     }
 }
 
+void Engine::apply_move(Move m) {
+    states->emplace_back();
+    pos.do_move(m, states->back());
+
+    capSq          = SQ_NONE;
+    DirtyPiece& dp = states->back().dirtyPiece;
+    if (dp.dirty_num > 1 && dp.to[1] == SQ_NONE)
+        capSq = m.to_sq();
+}
+
 // modifiers
 
 void Engine::set_numa_config_from_option(const std::string& o) {
@@ -204,17 +262,35 @@ void Engine::set_ponderhit(bool b) { threads.main_manager()->ponder = b; }
 
 // network related
 
-void Engine::verify_networks() const {
-    networks->big.verify();
-    networks->small.verify();
-}
+// Karuah Chess - the search can run on the small network alone, while the big
+// network is loading or when it failed to load
+void Engine::verify_networks() const { networks->small.verify(); }
 
-void Engine::load_networks() {
-    networks.modify_and_replicate([this](NN::Networks& networks_) {
-        networks_.big.load();
-        networks_.small.load();
-    });
-    threads.clear();
+void Engine::wait_for_networks() { swap_in_big_network(true); }
+
+// Karuah Chess - copies the big network in to the networks used by the search once
+// it has loaded, or waits for it to load. A network that failed to load is not
+// copied in, so the search stays on the small network. The error is reported by
+// the shared networks.
+void Engine::swap_in_big_network(bool wait) {
+    if (bigNetworkSwapped)
+        return;
+
+    const NN::NetworkBig* bigNetwork =
+      wait ? &sharedNetworks->wait_for_big() : sharedNetworks->big_if_loaded();
+    if (!bigNetwork)
+        return;
+
+    bigNetworkSwapped = true;
+    if (!bigNetwork->is_loaded())
+        return;
+
+    threads.wait_for_search_finished();
+
+    networks.modify_and_replicate(
+      [bigNetwork](NN::Networks& networks_) { networks_.big = *bigNetwork; });
+
+    threads.clear_refresh_tables();
     threads.ensure_network_replicated();
 }
 
@@ -232,6 +308,8 @@ void Engine::trace_eval() const {
 const OptionsMap& Engine::get_options() const { return options; }
 OptionsMap&       Engine::get_options() { return options; }
 
+const Eval::NNUE::Networks& Engine::get_networks() const { return *networks; }
+
 std::string Engine::fen() const { return pos.fen(); }
 
 void Engine::flip() { pos.flip(); }
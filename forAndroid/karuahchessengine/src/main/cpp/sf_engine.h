@@ -22,6 +22,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -30,6 +31,7 @@
 
 #include "nnue/network.h"
 #include "sf_numa.h"
+#include "sf_perft.h"
 #include "sf_position.h"
 #include "sf_search.h"
 #include "syzygy/tbprobe.h"  // for Stockfish::Depth
@@ -47,7 +49,8 @@ class Engine {
     using InfoFull  = Search::InfoFull;
     using InfoIter  = Search::InfoIteration;
 
-    Engine();
+    // Karuah Chess - the engine evaluates with the shared networks, see SharedNetworks
+    explicit Engine(std::shared_ptr<const Eval::NNUE::SharedNetworks> sharedNetworks);
 
     // Cannot be movable due to components holding backreferences to fields
     Engine(const Engine&)            = delete;
@@ -55,7 +58,7 @@ class Engine {
     Engine& operator=(const Engine&) = delete;
     Engine& operator=(Engine&&)      = delete;
 
-    ~Engine() { wait_for_search_finished(); }
+    ~Engine();
         
     // non blocking call to start searching
     void go(Search::LimitsType&);
@@ -64,8 +67,18 @@ class Engine {
 
     // blocking call to wait for search to finish
     void wait_for_search_finished();
+    // Karuah Chess - blocking perft with the root moves split across the search threads,
+    // using a perft hash of hashMB megabytes when hashMB is not zero
+    uint64_t perft(const std::string&                       fen,
+                   Depth                                    depth,
+                   size_t                                   hashMB,
+                   std::vector<Benchmark::PerftDivideItem>& divide);
+    // Karuah Chess - blocking call running the job on each search thread, the job is passed the thread index
+    void run_on_threads(const std::function<void(size_t)>& job);
     // set a new position, moves are in UCI format
     void set_position(const std::string& fen, const std::vector<std::string>& moves);
+    // set a new position from a piece placement and state followed by the moves played from it
+    void set_position(const PositionSetup& setup, const std::vector<Move>& moves);
 
     // modifiers
 
@@ -82,10 +95,16 @@ class Engine {
     // Karuah Chess - including PV vector
     void set_on_bestmove(std::function<void(std::string_view, std::string_view, std::vector<Stockfish::Search::RootMove>)>&&);
 
+    // Karuah Chess - publish the search information to the queue instead of the callbacks, or to
+    // the callbacks again when null
+    void set_info_queue(std::shared_ptr<Search::InfoQueue>);
+
     // network related
 
     void verify_networks() const;
-    void load_networks();    
+    // Karuah Chess - blocking call to wait for the big network loading in the background,
+    // for results that must not depend on when it finished loading
+    void wait_for_networks();
     
     // utility functions
 
@@ -94,6 +113,9 @@ class Engine {
     const OptionsMap& get_options() const;
     OptionsMap&       get_options();
 
+    // Karuah Chess - networks of the first NUMA node, used by the benchmarks
+    const Eval::NNUE::Networks& get_networks() const;
+
     std::string                            fen() const;
     void                                   flip();    
     std::vector<std::pair<size_t, size_t>> get_bound_thread_count_by_numa_node() const;
@@ -109,11 +131,20 @@ class Engine {
     StateListPtr states;
     Square       capSq;
 
+    void apply_moves(const std::vector<std::string>& moves);
+    void apply_move(Move m);
+
     OptionsMap                               options;
     ThreadPool                               threads;
     TranspositionTable                       tt;
     LazyNumaReplicated<Eval::NNUE::Networks> networks;
 
+    // Karuah Chess - the big network is copied from the shared networks once it has loaded
+    void swap_in_big_network(bool wait);
+
+    std::shared_ptr<const Eval::NNUE::SharedNetworks> sharedNetworks;
+    bool                                              bigNetworkSwapped = false;
+
     Search::SearchManager::UpdateContext updateContext;
 };
 
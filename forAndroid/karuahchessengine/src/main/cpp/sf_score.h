@@ -55,6 +55,11 @@ class Score {
     T get() const {
         return std::get<T>(score);
     }
+
+    template<typename F>
+    decltype(auto) visit(F&& f) const {
+        return std::visit(std::forward<F>(f), score);
+    }
        
 
    private:
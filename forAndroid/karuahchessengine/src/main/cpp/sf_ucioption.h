@@ -57,6 +57,8 @@ class Option {
     friend class Engine;
     friend class Tune;
 
+    friend std::ostream& operator<<(std::ostream&, const OptionsMap&);
+
     void operator<<(const Option&);
 
     std::string       defaultValue, currentValue, type;
@@ -89,6 +91,8 @@ class OptionsMap {
     friend class Engine;
     friend class Option;
 
+    friend std::ostream& operator<<(std::ostream&, const OptionsMap&);
+
     // The options container is defined as a std::map
     using OptionsStore = std::map<std::string, Option, CaseInsensitiveLess>;
 
@@ -23,7 +23,7 @@ import android.content.res.AssetManager
 @ExperimentalUnsignedTypes
 class KaruahChessEngineC() {
 
-    external fun initialise(pAssetMgr: AssetManager, pId: Int)
+    external fun initialise(pAssetMgr: AssetManager, pCacheDir: String, pActivityID: Int, pId: Int)
 
     external fun getBoard(pId: Int): String
 
@@ -43,6 +43,8 @@ class KaruahChessEngineC() {
 
     external fun setStateArray(pStateArray : IntArray, pId: Int)
 
+    external fun replayMoveL(pNextBoardArray : LongArray, pNextStateArray : IntArray, pId: Int): Boolean
+
     external fun setStateWhiteClockOffset(pOffset : Int, pId: Int)
 
     external fun setStateBlackClockOffset(pOffset : Int, pId: Int)
@@ -53,7 +55,7 @@ class KaruahChessEngineC() {
 
     external fun reset(pId: Int)
 
-    external fun cancelSearch()
+    external fun cancelSearch(pId: Int)
 
     external fun getSpin(pIndex: Int, pId: Int): Int
 
@@ -65,6 +67,8 @@ class KaruahChessEngineC() {
 
     external fun setStateGameStatus(pStatus: Int, pId: Int)
 
+    external fun getGameStatus(pId: Int): Int
+
     external fun getStateFullMoveCount(pId: Int): Int
 
     external fun getStateCastlingAvailability(pId: Int): Int
@@ -75,6 +79,8 @@ class KaruahChessEngineC() {
 
     external fun getPotentialMoveL(pSqIndex: Int, pId: Int): Long
 
+    external fun getLegalMoveL(pSqIndex: Int, pId: Int): Long
+
     external fun move(pFromIndex: Int, pToIndex: Int, pPawnPromotionPiece: Int, pValidateEnabled: Boolean, pCommit: Boolean, pId: Int): MoveResult
 
     external fun arrange(pFromIndex: Int, pToIndex: Int, pId: Int): MoveResult
@@ -93,6 +99,10 @@ class KaruahChessEngineC() {
 
     external fun searchStart(pSearchOptions: SearchOptions, pId: Int): SearchResult
 
+    external fun ponderStart(pSearchOptions: SearchOptions, pId: Int): Boolean
+
+    external fun speculateStart(pSearchOptions: SearchOptions, pId: Int)
+
     external fun setStateCastlingAvailability(pCastlingAvailability: Int, pColour: Int, pId: Int): Boolean
 
     external fun cleanup(pId: Int)
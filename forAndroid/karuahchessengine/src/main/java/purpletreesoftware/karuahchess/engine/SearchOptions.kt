@@ -25,6 +25,5 @@ class SearchOptions {
     var limitMoveDuration: Int = 0
     var limitThreads: Int = 1
     var randomiseFirstMove: Boolean = false
-    var alternateMove: Boolean = false
 
 }
\ No newline at end of file
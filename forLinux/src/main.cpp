@@ -0,0 +1,136 @@
+/*
+Karuah Chess is a chess playing program
+Copyright (C) 2020-2023 Karuah Software
+
+Karuah Chess is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Karuah Chess is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "engine.h"
+#include "sf_evaluate.h"
+#include "sf_uci.h"
+#include "nnue/nnue_dispatch.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace KaruahChess;
+
+namespace {
+
+	/// <summary>
+	/// An NNUE file on disk. The file is only opened if the engine has to read it.
+	/// </summary>
+	Engine::NNUEFile nnueFile(const std::string& pFileName) {
+		std::error_code ec;
+		auto size = std::filesystem::file_size(pFileName, ec);
+
+		return { pFileName, ec ? 0L : long(size), [pFileName](char* pBuffer, long pSize) {
+			std::ifstream file(pFileName, std::ios::binary);
+			return bool(file.read(pBuffer, pSize));
+		} };
+	}
+
+	/// <summary>
+	/// Default directory for the converted networks, under the XDG cache directory
+	/// </summary>
+	std::string defaultCacheDir() {
+		if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') return std::string(xdg) + "/karuahchess";
+		if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') return std::string(home) + "/.cache/karuahchess";
+		return "";
+	}
+
+	/// <summary>
+	/// Peak resident memory of the process in kilobytes
+	/// </summary>
+	long peakMemoryKB() {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+	}
+
+	/// <summary>
+	/// Prints usage
+	/// </summary>
+	void printUsage() {
+		std::cout << "usage: karuahchess-uci [-big <file>] [-small <file>] [-cache <dir>] [-kernels <name>] [command]" << std::endl
+			<< "  -big <file>      big network (default " << EvalFileDefaultNameBig << ")" << std::endl
+			<< "  -small <file>    small network (default " << EvalFileDefaultNameSmall << ")" << std::endl
+			<< "  -cache <dir>     directory for the converted networks, empty to disable (default " << defaultCacheDir() << ")" << std::endl
+			<< "  -kernels <name>  NNUE kernels to use instead of the best supported" << std::endl
+			<< "  command          a single UCI command to run, otherwise commands are read from stdin" << std::endl;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+
+	std::string fileNameBig = EvalFileDefaultNameBig;
+	std::string fileNameSmall = EvalFileDefaultNameSmall;
+	std::string cacheDir = defaultCacheDir();
+	std::string kernels;
+	std::string command;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-big" && i + 1 < argc) fileNameBig = argv[++i];
+		else if (arg == "-small" && i + 1 < argc) fileNameSmall = argv[++i];
+		else if (arg == "-cache" && i + 1 < argc) cacheDir = argv[++i];
+		else if (arg == "-kernels" && i + 1 < argc) kernels = argv[++i];
+		else if (arg == "-h" || arg == "--help") {
+			printUsage();
+			return 0;
+		}
+		else command += (command.empty() ? "" : " ") + arg;
+	}
+
+	// The kernels must be selected before the networks are loaded
+	if (!kernels.empty() && !Stockfish::Eval::NNUE::select_kernels(kernels)) {
+		std::cerr << "info string NNUE kernels " << kernels << " are not supported, supported are";
+		for (const std::string& name : Stockfish::Eval::NNUE::supported_kernels()) std::cerr << " " << name;
+		std::cerr << std::endl;
+		return 1;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	Engine::NNUEFile nnueBig = nnueFile(fileNameBig);
+	Engine::NNUEFile nnueSmall = nnueFile(fileNameSmall);
+	if (nnueBig.size == 0) std::cerr << "info string unable to read " << fileNameBig << std::endl;
+	if (nnueSmall.size == 0) std::cerr << "info string unable to read " << fileNameSmall << std::endl;
+
+	Engine::init(nnueBig, nnueSmall, cacheDir);
+	Engine::Context context;
+
+	auto startupMS = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "info string startup " << startupMS << " ms, memory " << peakMemoryKB() << " KB, NNUE kernels "
+		<< Stockfish::Eval::NNUE::kernels().name << std::endl;
+
+	std::vector<int> errors = Engine::engineErr.list();
+	if (!errors.empty()) {
+		for (int error : errors) {
+			std::cerr << "info string engine error " << error << std::endl;
+		}
+		return 1;
+	}
+
+	context.uci().loop(command);
+
+	return 0;
+}
@@ -0,0 +1,472 @@
+/*
+Karuah Chess is a chess playing program
+Copyright (C) 2020-2023 Karuah Software
+
+Karuah Chess is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Karuah Chess is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "engine.h"
+#include "bitboard.h"
+#include "moverules.h"
+#include "helper.h"
+#include "sf_evaluate.h"
+#include "sf_movegen.h"
+#include "sf_movepick.h"
+#include "sf_position.h"
+#include "sf_thread.h"
+#include "sf_tt.h"
+#include "sf_uci.h"
+#include "nnue/network.h"
+#include "nnue/nnue_accumulator.h"
+#include "nnue/nnue_dispatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace KaruahChess;
+
+namespace {
+
+	// Positions the benchmarks run over, from the opening to the endgame
+	const std::vector<std::string> BenchPositions = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+		"r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+		"4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+		"6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1"
+	};
+
+	struct BenchOptions {
+		int warmup = 3;
+		int repetitions = 15;
+		double minRepetitionMS = 20.0;
+		std::string filter;
+		std::string jsonFileName;
+		std::string label;
+	};
+
+	// Timings of a benchmark in nanoseconds per operation
+	struct BenchResult {
+		std::string name;
+		uint64_t opsPerRepetition = 0;
+		std::vector<double> nsPerOp;
+		double min = 0;
+		double median = 0;
+		double p10 = 0;
+		double p90 = 0;
+		double max = 0;
+	};
+
+	// A benchmark runs its operations once and returns the number of operations done
+	struct MicroBenchmark {
+		std::string name;
+		std::function<uint64_t()> run;
+	};
+
+	// Results are added to the sink so the compiler does not remove the work
+	volatile uint64_t sink = 0;
+
+
+	/// <summary>
+	/// Gets the value at a percentile of sorted values
+	/// </summary>
+	double percentile(const std::vector<double>& pSorted, double pPercent) {
+		if (pSorted.empty()) return 0;
+		double rank = pPercent / 100.0 * double(pSorted.size() - 1);
+		size_t lower = size_t(rank);
+		size_t upper = std::min(lower + 1, pSorted.size() - 1);
+		return pSorted[lower] + (pSorted[upper] - pSorted[lower]) * (rank - double(lower));
+	}
+
+
+	/// <summary>
+	/// Runs a benchmark. The operations are repeated until a repetition takes at least the minimum time,
+	/// then the warmup repetitions are discarded and the timed repetitions measured.
+	/// </summary>
+	BenchResult runBenchmark(const MicroBenchmark& pBenchmark, const BenchOptions& pOptions) {
+		using clock = std::chrono::steady_clock;
+
+		BenchResult result;
+		result.name = pBenchmark.name;
+
+		// Calibrate the number of runs in a repetition
+		uint64_t runs = 1;
+		for (;;) {
+			auto start = clock::now();
+			for (uint64_t i = 0; i < runs; i++) pBenchmark.run();
+			double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+			if (ms >= pOptions.minRepetitionMS || runs >= (1ULL << 30)) break;
+			runs *= 2;
+		}
+
+		for (int rep = 0; rep < pOptions.warmup + pOptions.repetitions; rep++) {
+			uint64_t ops = 0;
+			auto start = clock::now();
+			for (uint64_t i = 0; i < runs; i++) ops += pBenchmark.run();
+			double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+			if (rep >= pOptions.warmup && ops > 0) {
+				result.nsPerOp.push_back(ns / double(ops));
+				result.opsPerRepetition = ops;
+			}
+		}
+
+		std::vector<double> sorted = result.nsPerOp;
+		std::sort(sorted.begin(), sorted.end());
+		if (!sorted.empty()) {
+			result.min = sorted.front();
+			result.max = sorted.back();
+			result.median = percentile(sorted, 50);
+			result.p10 = percentile(sorted, 10);
+			result.p90 = percentile(sorted, 90);
+		}
+
+		return result;
+	}
+
+
+	/// <summary>
+	/// Writes the results as JSON
+	/// </summary>
+	void writeJSON(std::ostream& pStream, const std::vector<BenchResult>& pResults, const BenchOptions& pOptions) {
+		pStream << std::setprecision(6) << "{\n"
+			<< "  \"label\": \"" << pOptions.label << "\",\n"
+			<< "  \"kernels\": \"" << Stockfish::Eval::NNUE::kernels().name << "\",\n"
+			<< "  \"warmup\": " << pOptions.warmup << ",\n"
+			<< "  \"repetitions\": " << pOptions.repetitions << ",\n"
+			<< "  \"unit\": \"ns/op\",\n"
+			<< "  \"benchmarks\": [\n";
+
+		for (size_t i = 0; i < pResults.size(); i++) {
+			const BenchResult& r = pResults[i];
+			pStream << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.opsPerRepetition
+				<< ", \"min\": " << r.min << ", \"p10\": " << r.p10 << ", \"median\": " << r.median
+				<< ", \"p90\": " << r.p90 << ", \"max\": " << r.max << ", \"samples\": [";
+			for (size_t s = 0; s < r.nsPerOp.size(); s++) {
+				pStream << (s > 0 ? ", " : "") << r.nsPerOp[s];
+			}
+			pStream << "]}" << (i + 1 < pResults.size() ? "," : "") << "\n";
+		}
+
+		pStream << "  ]\n}\n";
+	}
+
+
+	/// <summary>
+	/// An NNUE file on disk. The file is only opened if the engine has to read it.
+	/// </summary>
+	Engine::NNUEFile nnueFile(const std::string& pFileName) {
+		std::error_code ec;
+		auto size = std::filesystem::file_size(pFileName, ec);
+
+		return { pFileName, ec ? 0L : long(size), [pFileName](char* pBuffer, long pSize) {
+			std::ifstream file(pFileName, std::ios::binary);
+			return bool(file.read(pBuffer, pSize));
+		} };
+	}
+
+
+	/// <summary>
+	/// Prints usage
+	/// </summary>
+	void printUsage() {
+		std::cout << "usage: karuahchess-microbench [options]" << std::endl
+			<< "  -big <file>      big network (default " << EvalFileDefaultNameBig << ")" << std::endl
+			<< "  -small <file>    small network (default " << EvalFileDefaultNameSmall << ")" << std::endl
+			<< "  -kernels <name>  NNUE kernels to use instead of the best supported" << std::endl
+			<< "  -warmup <n>      warmup repetitions (default 3)" << std::endl
+			<< "  -reps <n>        timed repetitions (default 15)" << std::endl
+			<< "  -mintime <ms>    minimum time of a repetition (default 20)" << std::endl
+			<< "  -filter <text>   only run benchmarks with names containing the text" << std::endl
+			<< "  -json <file>     write the results as JSON" << std::endl
+			<< "  -label <text>    label written to the JSON, eg a commit id" << std::endl;
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+	BenchOptions options;
+	std::string fileNameBig = EvalFileDefaultNameBig;
+	std::string fileNameSmall = EvalFileDefaultNameSmall;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-big" && hasValue) fileNameBig = argv[++i];
+		else if (arg == "-small" && hasValue) fileNameSmall = argv[++i];
+		else if (arg == "-kernels" && hasValue) {
+			if (!Stockfish::Eval::NNUE::select_kernels(argv[++i])) {
+				std::cerr << "NNUE kernels " << argv[i] << " are not supported" << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "-warmup" && hasValue) options.warmup = std::stoi(argv[++i]);
+		else if (arg == "-reps" && hasValue) options.repetitions = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "-mintime" && hasValue) options.minRepetitionMS = std::stod(argv[++i]);
+		else if (arg == "-filter" && hasValue) options.filter = argv[++i];
+		else if (arg == "-json" && hasValue) options.jsonFileName = argv[++i];
+		else if (arg == "-label" && hasValue) options.label = argv[++i];
+		else {
+			printUsage();
+			return arg == "-h" || arg == "--help" ? 0 : 1;
+		}
+	}
+
+	// The networks are read without the weight blob cache, so the benchmarks do
+	// not depend on an earlier run
+	Engine::init(nnueFile(fileNameBig), nnueFile(fileNameSmall), "");
+
+	using namespace Stockfish;
+
+	// Stockfish positions
+	std::vector<std::unique_ptr<Position>> positions;
+	std::vector<StateListPtr> positionStates;
+	for (const std::string& fen : BenchPositions) {
+		positionStates.emplace_back(new std::deque<StateInfo>(1));
+		positions.push_back(std::make_unique<Position>());
+		positions.back()->set(fen, false, &positionStates.back()->back());
+	}
+
+	// Karuah Chess boards of the same positions
+	std::vector<std::unique_ptr<BitBoard>> boards;
+	for (const auto& pos : positions) {
+		boards.push_back(std::make_unique<BitBoard>());
+		Engine::fromPosition(*pos, *boards.back());
+	}
+
+	std::vector<MicroBenchmark> benchmarks;
+
+	benchmarks.push_back({ "sf_position_do_undo_move", [&]() {
+		uint64_t ops = 0;
+		StateInfo st;
+		for (auto& pos : positions) {
+			for (const auto& m : MoveList<LEGAL>(*pos)) {
+				pos->do_move(m, st);
+				pos->undo_move(m);
+				ops++;
+			}
+		}
+		return ops;
+	} });
+
+	benchmarks.push_back({ "sf_generate_legal", [&]() {
+		uint64_t ops = 0;
+		for (auto& pos : positions) {
+			sink = sink + MoveList<LEGAL>(*pos).size();
+			ops++;
+		}
+		return ops;
+	} });
+
+	// Move picker with zeroed histories, one operation is a full iteration of the moves of a position
+	auto mainHistory = std::make_unique<ButterflyHistory>();
+	auto captureHistory = std::make_unique<CapturePieceToHistory>();
+	auto pieceToHistory = std::make_unique<PieceToHistory>();
+	auto pawnHistory = std::make_unique<PawnHistory>();
+	mainHistory->fill(0);
+	captureHistory->fill(0);
+	pieceToHistory->fill(0);
+	pawnHistory->fill(0);
+	const PieceToHistory* continuationHistory[6] = { pieceToHistory.get(), pieceToHistory.get(), pieceToHistory.get(),
+		pieceToHistory.get(), pieceToHistory.get(), pieceToHistory.get() };
+
+	benchmarks.push_back({ "sf_movepicker_iterate", [&]() {
+		uint64_t ops = 0;
+		for (auto& pos : positions) {
+			MovePicker mp(*pos, Move::none(), 5, mainHistory.get(), captureHistory.get(), continuationHistory, pawnHistory.get());
+			while (mp.next_move() != Move::none()) sink = sink + 1;
+			ops++;
+		}
+		return ops;
+	} });
+
+	// Transposition table of 16MB with half of the probed keys written
+	ThreadPool noThreads;
+	TranspositionTable tt;
+	tt.resize(16, noThreads);
+	std::vector<Key> ttKeys(1 << 16);
+	std::mt19937_64 random(20240101);
+	for (size_t i = 0; i < ttKeys.size(); i++) {
+		ttKeys[i] = random();
+		if (i % 2 == 0) {
+			auto [hit, data, writer] = tt.probe(ttKeys[i]);
+			writer.write(ttKeys[i], VALUE_ZERO, false, BOUND_EXACT, 10, Move::none(), VALUE_ZERO, tt.generation());
+		}
+	}
+
+	benchmarks.push_back({ "sf_tt_probe", [&]() {
+		for (Key key : ttKeys) {
+			auto [hit, data, writer] = tt.probe(key);
+			sink = sink + hit;
+		}
+		return uint64_t(ttKeys.size());
+	} });
+
+	// Network evaluation. The incremental benchmarks make each legal move, update the accumulator
+	// from the parent position and evaluate. The refresh benchmarks evaluate with no computed accumulator.
+	Engine::Context context;
+	context.uci().engine.wait_for_networks();
+	const Eval::NNUE::Networks& networks = context.uci().engine.get_networks();
+	auto caches = std::make_unique<Eval::NNUE::AccumulatorCaches>(networks);
+
+	auto addNetworkBenchmarks = [&](const std::string& pName, bool pLoaded, auto pEvaluate, auto pAccumulator) {
+		if (!pLoaded) {
+			std::cerr << "skipping " << pName << " benchmarks, the network is not loaded" << std::endl;
+			return;
+		}
+
+		benchmarks.push_back({ "nnue_" + pName + "_evaluate_incremental", [&positions, pEvaluate]() {
+			uint64_t ops = 0;
+			StateInfo st;
+			for (auto& pos : positions) {
+				pEvaluate(*pos);
+				for (const auto& m : MoveList<LEGAL>(*pos)) {
+					pos->do_move(m, st);
+					pEvaluate(*pos);
+					pos->undo_move(m);
+					ops++;
+				}
+			}
+			return ops;
+		} });
+
+		benchmarks.push_back({ "nnue_" + pName + "_evaluate_refresh", [&positions, pEvaluate, pAccumulator]() {
+			for (auto& pos : positions) {
+				auto& accumulator = pos->state()->*pAccumulator;
+				accumulator.computed[WHITE] = accumulator.computed[BLACK] = false;
+				pEvaluate(*pos);
+			}
+			return uint64_t(positions.size());
+		} });
+	};
+
+	addNetworkBenchmarks("big", Engine::nnueLoadedBig,
+		[&networks, &caches](const Position& pPos) { sink = sink + std::get<0>(networks.big.evaluate(pPos, &caches->big)); },
+		&StateInfo::accumulatorBig);
+	addNetworkBenchmarks("small", Engine::nnueLoadedSmall,
+		[&networks, &caches](const Position& pPos) { sink = sink + std::get<0>(networks.small.evaluate(pPos, &caches->small)); },
+		&StateInfo::accumulatorSmall);
+
+	// Karuah Chess board
+	benchmarks.push_back({ "kc_bitboard_update", [&]() {
+		uint64_t ops = 0;
+		for (auto& board : boards) {
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) {
+				if (board->GetSpin(sqIndex) != 0) continue;
+				board->Update(sqIndex, helper::WHITE_KNIGHT_SPIN);
+				board->Update(sqIndex, 0);
+				ops += 2;
+			}
+		}
+		return ops;
+	} });
+
+	benchmarks.push_back({ "kc_bitboard_attack_paths_incremental", [&]() {
+		uint64_t ops = 0;
+		for (auto& board : boards) {
+			for (int sqIndex = 0; sqIndex < 64; sqIndex++) {
+				if (board->GetSpin(sqIndex) != 0) continue;
+				board->Update(sqIndex, helper::WHITE_KNIGHT_SPIN);
+				sink = sink + board->GetPseudoLegalMove(sqIndex);
+				board->Update(sqIndex, 0);
+				sink = sink + board->GetPseudoLegalMove(sqIndex);
+				ops += 2;
+			}
+		}
+		return ops;
+	} });
+
+	// Boards which have not calculated their attack paths. One operation copies a board and calculates all attack paths.
+	std::vector<std::unique_ptr<BitBoard>> rebuildBoards;
+	for (const auto& pos : positions) {
+		rebuildBoards.push_back(std::make_unique<BitBoard>());
+		Engine::fromPosition(*pos, *rebuildBoards.back());
+	}
+
+	BitBoard scratchBoard;
+	benchmarks.push_back({ "kc_bitboard_attack_paths_rebuild", [&]() {
+		for (auto& board : rebuildBoards) {
+			board->Copy(scratchBoard);
+			sink = sink + scratchBoard.GetPseudoLegalMove(0);
+		}
+		return uint64_t(rebuildBoards.size());
+	} });
+
+	benchmarks.push_back({ "kc_moverules_move", [&]() {
+		uint64_t ops = 0;
+		MoveRules::MoveList moveList;
+		for (auto& board : boards) {
+			MoveRules::GenerateLegalMoves(*board, moveList);
+			for (int i = 0; i < moveList.count; i++) {
+				const MoveRules::MoveListItem& move = moveList.moves[i];
+				helper::PawnPromotionEnum promotion = move.promotionPieceType > 0 ? (helper::PawnPromotionEnum)move.promotionPieceType : helper::PawnPromotionEnum::Queen;
+				sink = sink + MoveRules::Move(move.fromIndex, move.toIndex, *board, promotion, true, false);
+				ops++;
+			}
+		}
+		return ops;
+	} });
+
+	benchmarks.push_back({ "kc_generate_legal", [&]() {
+		uint64_t ops = 0;
+		MoveRules::MoveList moveList;
+		for (auto& board : boards) {
+			MoveRules::GenerateLegalMoves(*board, moveList);
+			sink = sink + moveList.count;
+			ops++;
+		}
+		return ops;
+	} });
+
+	// Run
+	std::vector<BenchResult> results;
+	std::cout << "NNUE kernels " << Stockfish::Eval::NNUE::kernels().name << std::endl;
+	std::cout << std::left << std::setw(40) << "benchmark" << std::right
+		<< std::setw(12) << "min" << std::setw(12) << "p10" << std::setw(12) << "median"
+		<< std::setw(12) << "p90" << std::setw(12) << "max" << "  ns/op" << std::endl;
+
+	for (const MicroBenchmark& benchmark : benchmarks) {
+		if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) continue;
+
+		BenchResult r = runBenchmark(benchmark, options);
+		std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << r.min << std::setw(12) << r.p10 << std::setw(12) << r.median
+			<< std::setw(12) << r.p90 << std::setw(12) << r.max << std::endl;
+		results.push_back(std::move(r));
+	}
+
+	if (!options.jsonFileName.empty()) {
+		std::ofstream file(options.jsonFileName);
+		if (!file) {
+			std::cerr << "unable to write " << options.jsonFileName << std::endl;
+			return 1;
+		}
+		writeJSON(file, results, options);
+	}
+
+	return 0;
+}